@@ -0,0 +1,214 @@
+//
+//  band_solver.cpp
+//  SuDoKuSolver
+//
+//  Copyright © 2018 Hermes Productions. All rights reserved.
+//
+#include "defines.hpp"
+
+#include "band_solver.hpp"
+#include "grid.hpp"
+
+namespace {
+  const uint32_t ROW = 0x1FF;
+  // One column copied into the three rows of a band
+  const uint32_t COLUMN = 0x40201;
+  const uint32_t BLOCK = 0x7 * COLUMN;
+
+  // Cells sharing a row, column or block with each cell, by band
+  struct Peers {
+    uint32_t masks[81][3];
+    Peers() {
+      for (UINT i = 0; i < 81; ++i) {
+        UINT band = i / 27, row = i % 27 / 9, col = i % 9;
+        for (UINT b = 0; b < 3; ++b) masks[i][b] = COLUMN << col;
+        masks[i][band] |= ROW << (9 * row);
+        masks[i][band] |= BLOCK << (col / 3 * 3);
+        masks[i][band] &= ~(uint32_t(1) << (i % 27));
+      }
+    }
+  };
+  const Peers PEERS;
+
+  inline uint32_t Lowest(uint32_t bits) { return bits & (~bits + 1); }
+  inline UINT Index(uint32_t bit) { return __builtin_ctz(bit); }
+}
+
+UINT BandSearch::Solve(const uint16_t* cells, const SolveLimits& limits) {
+  _count = _guesses = _nodes = 0;
+  _limits = &limits;
+  _stopped = false;
+  State state = {};
+  for (UINT i = 0; i < 81; ++i) {
+    uint32_t bit = uint32_t(1) << (i % 27);
+    state.unsolved[i / 27] |= bit;
+    for (UINT v = 0; v < 9; ++v) {
+      if (cells[i] >> v & 1) state.boards[v][i / 27] |= bit;
+    }
+  }
+  state.changed = (1 << 9) - 1;
+  Search(state, 0);
+  _limits = nullptr;
+  return _count;
+}
+
+void BandSearch::GetSolution(uint16_t* cells) const {
+  for (UINT i = 0; i < 81; ++i) {
+    cells[i] = 0;
+    for (UINT v = 0; v < 9; ++v) {
+      if (_solution.boards[v][i / 27] >> (i % 27) & 1) cells[i] = 1 << v;
+    }
+  }
+}
+
+bool BandSearch::Search(State& state, UINT guesses) {
+  // Returns true once enough solutions are found, or the limits run out,
+  // to stop
+  if (_limits->Exceeded(++_nodes)) {
+    _stopped = true;
+    return true;
+  }
+  if (!Propagate(state)) return false;
+  if (!(state.unsolved[0] | state.unsolved[1] | state.unsolved[2])) {
+    ++_count;
+    _guesses += guesses;
+    _solution = state;
+    return _count == 2;
+  }
+
+  // Branch on a cell with two candidates if there is one, else the fewest
+  UINT band = 0, fewest = 10;
+  uint32_t cell = 0;
+  for (UINT b = 0; b < 3 && fewest > 2; ++b) {
+    uint32_t once = 0, twice = 0, more = 0;
+    for (UINT v = 0; v < 9; ++v) {
+      more |= twice & state.boards[v][b];
+      twice |= once & state.boards[v][b];
+      once |= state.boards[v][b];
+    }
+    uint32_t pairs = state.unsolved[b] & twice & ~more;
+    if (pairs) {
+      band = b;
+      cell = Lowest(pairs);
+      fewest = 2;
+    }
+  }
+  for (UINT b = 0; b < 3 && fewest > 2; ++b) {
+    for (uint32_t left = state.unsolved[b]; left; left &= left - 1) {
+      uint32_t bit = Lowest(left);
+      UINT count = 0;
+      for (UINT v = 0; v < 9; ++v) count += (state.boards[v][b] & bit) != 0;
+      if (count < fewest) {
+        band = b;
+        cell = bit;
+        fewest = count;
+      }
+    }
+  }
+
+  for (UINT v = 0; v < 9; ++v) {
+    if (!(state.boards[v][band] & cell)) continue;
+    State next = state;
+    Place(next, v, band, cell);
+    if (Search(next, guesses + 1)) return true;
+  }
+  return false;
+}
+
+bool BandSearch::Propagate(State& state) const {
+  // Place naked and hidden singles until none are left. Returns false as
+  // soon as a cell or group value runs out of options.
+  while (true) {
+    // Naked singles, counting how many boards hold each cell
+    bool placed = false;
+    for (UINT b = 0; b < 3; ++b) {
+      uint32_t once = 0, twice = 0;
+      for (UINT v = 0; v < 9; ++v) {
+        twice |= once & state.boards[v][b];
+        once |= state.boards[v][b];
+      }
+      if (state.unsolved[b] & ~once) return false;
+      for (uint32_t singles = state.unsolved[b] & ~twice; singles; singles &= singles - 1) {
+        uint32_t bit = Lowest(singles);
+        UINT v = 0;
+        while (v < 9 && !(state.boards[v][b] & bit)) ++v;
+        // Taken by a single placed just before
+        if (v == 9) return false;
+        Place(state, v, b, bit);
+        placed = true;
+      }
+    }
+    if (placed) continue;
+
+    // Hidden singles. Solved cells stay on their value's board, so a group
+    // holding one bit of a board is either solved or a hidden single.
+    for (UINT v = 0; v < 9; ++v) {
+      if (!(state.changed >> v & 1)) continue;
+      state.changed &= ~(uint32_t(1) << v);
+      uint32_t* board = state.boards[v];
+      uint32_t hidden[3] = {0, 0, 0}, once = 0, twice = 0;
+      for (UINT b = 0; b < 3; ++b) {
+        for (UINT k = 0; k < 3; ++k) {
+          uint32_t row = board[b] & (ROW << (9 * k));
+          uint32_t block = board[b] & (BLOCK << (3 * k));
+          if (!row || !block) return false;
+          if (!(row & (row - 1))) hidden[b] |= row;
+          if (!(block & (block - 1))) hidden[b] |= block;
+          uint32_t cols = board[b] >> (9 * k) & ROW;
+          twice |= once & cols;
+          once |= cols;
+        }
+      }
+      if (once != ROW) return false;
+      uint32_t single_cols = (once & ~twice) * COLUMN;
+      for (UINT b = 0; b < 3; ++b) {
+        hidden[b] |= board[b] & single_cols;
+        for (hidden[b] &= state.unsolved[b]; hidden[b]; hidden[b] &= hidden[b] - 1) {
+          uint32_t bit = Lowest(hidden[b]);
+          // Cleared by another hidden single just placed, which the next
+          // pass reports as a contradiction
+          if (!(board[b] & bit) || !(state.unsolved[b] & bit)) continue;
+          Place(state, v, b, bit);
+          placed = true;
+        }
+      }
+    }
+    if (!placed) return true;
+  }
+}
+
+void BandSearch::Place(State& state, UINT v, UINT band, uint32_t bit) {
+  const uint32_t* peers = PEERS.masks[band * 27 + Index(bit)];
+  for (UINT b = 0; b < 3; ++b) state.boards[v][b] &= ~peers[b];
+  for (UINT w = 0; w < 9; ++w) {
+    if (w == v || !(state.boards[w][band] & bit)) continue;
+    state.boards[w][band] &= ~bit;
+    state.changed |= 1 << w;
+  }
+  state.changed |= 1 << v;
+  state.unsolved[band] &= ~bit;
+}
+
+BandSolver::BandSolver(SudokuGrid<3,3,81>& grid)
+: ISudokuSolver<3,3,81>(grid), _score(0) { }
+
+bool BandSolver::Solve() {
+  uint16_t cells[81];
+  _score = 0;
+  for (UINT i = 0; i < 81; ++i) {
+    cells[i] = (uint16_t)_AT(_initial, i).to_ulong();
+    if (!_grid.GetCell(i).IsFixed()) ++_score;
+  }
+  UINT count = _search.Solve(cells, _limits);
+  _stats.nodes = _search.GetNodes();
+  if (_search.Stopped()) {
+    _result = SolveResult::UNKNOWN;
+    return false;
+  }
+  _score += 100 * _search.GetGuesses();
+  if (count) {
+    _search.GetSolution(cells);
+    for (UINT i = 0; i < 81; ++i) _AT(_solved, i) = Values(cells[i]);
+  }
+  return Finish(count == 1);
+}
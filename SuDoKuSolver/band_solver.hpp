@@ -0,0 +1,71 @@
+//
+//  band_solver.hpp
+//  SuDoKuSolver
+//
+//  Copyright © 2018 Hermes Productions. All rights reserved.
+//
+
+#ifndef SUDOKUSOLVER_BAND_SOLVER_HPP
+#define SUDOKUSOLVER_BAND_SOLVER_HPP
+
+#include "defines.hpp"
+
+#include <cstdint>
+
+#include "solver.hpp"
+
+// Search specialised to regular 9x9 grids. Each value has an 81 bit board
+// of the cells it could still go in, held as three bands of three rows in
+// the low 27 bits of a word. Placing a value clears its row, column and
+// block from its board with a mask per band, singles are found by counting
+// across boards with bitwise operations, and a guess copies 30 words.
+class BandSearch {
+public:
+  BandSearch() : _count(0), _guesses(0), _nodes(0), _limits(nullptr), _stopped(false) { }
+  // Search from the candidate values of every cell, bit v meaning value
+  // v + 1, until two solutions are found or the limits, checked at each
+  // node, run out. Returns how many were found.
+  UINT Solve(const uint16_t*, const SolveLimits& = SolveLimits());
+  // Guesses on the path to each solution found, summed
+  inline UINT GetGuesses() const { return _guesses; }
+  inline UINT GetNodes() const { return _nodes; }
+  // Whether the last search ran out of its limits before finishing
+  inline bool Stopped() const { return _stopped; }
+  // Value bit of every cell in the last solution found
+  void GetSolution(uint16_t*) const;
+
+private:
+  struct State {
+    uint32_t boards[9][3];
+    uint32_t unsolved[3];
+    // Values whose boards changed since hidden singles last looked
+    uint32_t changed;
+  };
+
+  UINT _count, _guesses, _nodes;
+  const SolveLimits* _limits;
+  bool _stopped;
+  State _solution;
+
+private:
+  bool Search(State&, UINT);
+  bool Propagate(State&) const;
+  static void Place(State&, UINT, UINT, uint32_t);
+};
+
+// BandSearch behind the usual solver interface, for SudokuGrid<3>. Scores
+// the same way as BruteForceSolver: unfixed cells plus 100 per guess on
+// the path to each solution.
+class BandSolver : public ISudokuSolver<3,3,81> {
+public:
+  BandSolver(SudokuGrid<3,3,81>&);
+  virtual bool Solve();
+  inline UINT GetScore() { return _score; }
+  inline UINT GetNodes() { return _search.GetNodes(); }
+
+private:
+  BandSearch _search;
+  UINT _score;
+};
+
+#endif /* SUDOKUSOLVER_BAND_SOLVER_HPP */
@@ -0,0 +1,162 @@
+//
+//  batch_solver.cpp
+//  SuDoKuSolver
+//
+//  Copyright © 2018 Hermes Productions. All rights reserved.
+//
+#include "defines.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "batch_solver.hpp"
+#include "lanes.hpp"
+#include "solver.hpp"
+
+using namespace lanes;
+
+namespace {
+  const uint16_t ALL = (1 << 9) - 1;
+}
+
+const UINT BatchSolver::LANES;
+
+BatchSolver::BatchSolver() : _branched(0) {
+  // Rows, columns then blocks, as the grid orders them
+  for (UINT g = 0; g < G; ++g) {
+    for (UINT i = 0; i < G; ++i) {
+      _groups[g][i] = g * G + i;
+      _groups[G + g][i] = i * G + g;
+      _groups[2 * G + g][i] = (g / 3 * 3 + i / 3) * G + g % 3 * 3 + i % 3;
+    }
+  }
+}
+
+void BatchSolver::Solve(const std::vector<std::string>& puzzles,
+                        std::vector<Result>& results) {
+  results.resize(puzzles.size());
+  _branched = 0;
+  for (UINT first = 0; first < puzzles.size(); first += LANES) {
+    UINT lanes = std::min(LANES, (UINT)puzzles.size() - first);
+    // Unused lanes stay empty and count as broken
+    std::memset(_cells, 0, sizeof(_cells));
+    std::array<bool, LANES> loaded;
+    for (UINT lane = 0; lane < lanes; ++lane) {
+      loaded[lane] = Load(puzzles[first + lane], lane);
+    }
+    Propagate();
+
+    for (UINT lane = 0; lane < lanes; ++lane) {
+      const std::string& puzzle = puzzles[first + lane];
+      Result& result = results[first + lane];
+      if (!loaded[lane]) {
+        ++_branched;
+        Scalar(puzzle, result);
+        continue;
+      }
+      result.score = std::count(puzzle.begin(), puzzle.end(), '.');
+      if (Solved(lane)) {
+        // Singles alone filled the grid, so it has exactly one solution
+        result.unique = true;
+        for (UINT i = 0; i < N; ++i) result.solved[i] = _cells[i][lane];
+      } else {
+        // Singles reach the same fixpoint whatever their order, so the
+        // search continues exactly as it would from the puzzle itself.
+        // Without a solution the result holds the grid's initial state,
+        // which only the grid builds.
+        ++_branched;
+        if (!Scalar(lane, result)) Scalar(puzzle, result);
+      }
+    }
+  }
+}
+
+bool BatchSolver::Load(const std::string& puzzle, UINT lane) {
+  // Anything the scalar path would reject or treat differently is left to it
+  if (puzzle.size() != N) return false;
+  for (UINT i = 0; i < N; ++i) {
+    char c = puzzle[i];
+    if (c == '.') _cells[i][lane] = ALL;
+    else if (c >= '1' && c <= '9') _cells[i][lane] = 1 << (c - '1');
+    else return false;
+  }
+  return true;
+}
+
+void BatchSolver::Propagate() {
+  // Every step only narrows candidates, so this reaches a fixpoint. Lanes
+  // that contradict themselves carry on harmlessly and are marked broken.
+  Lanes broken = Zero(), all = Fill(ALL);
+  bool changed = true;
+  while (changed) {
+    Lanes diff = Zero();
+    for (const std::array<UINT, G>& group : _groups) {
+      // Naked singles: clear each solved value from the rest of the group,
+      // a value solved twice is a contradiction
+      Lanes seen = Zero(), twice = Zero();
+      for (UINT idx : group) {
+        Lanes single = Single(LoadLanes(_cells[idx]));
+        twice = Or(twice, And(seen, single));
+        seen = Or(seen, single);
+      }
+      broken = Or(broken, twice);
+      for (UINT idx : group) {
+        Lanes cell = LoadLanes(_cells[idx]);
+        Lanes next = AndNot(cell, AndNot(seen, Single(cell)));
+        diff = Or(diff, Xor(cell, next));
+        StoreLanes(_cells[idx], next);
+      }
+
+      // Hidden singles: a value with one place left goes there, a value with
+      // none is a contradiction
+      Lanes once = Zero();
+      twice = Zero();
+      for (UINT idx : group) {
+        Lanes cell = LoadLanes(_cells[idx]);
+        twice = Or(twice, And(once, cell));
+        once = Or(once, cell);
+      }
+      broken = Or(broken, AndNot(all, once));
+      Lanes only = AndNot(once, twice);
+      for (UINT idx : group) {
+        Lanes cell = LoadLanes(_cells[idx]);
+        Lanes next = Narrow(cell, And(cell, only));
+        diff = Or(diff, Xor(cell, next));
+        StoreLanes(_cells[idx], next);
+      }
+    }
+    changed = Any(diff);
+  }
+  for (UINT i = 0; i < N; ++i) broken = Or(broken, IsZero(LoadLanes(_cells[i])));
+  StoreLanes(_broken, broken);
+}
+
+bool BatchSolver::Solved(UINT lane) const {
+  if (_broken[lane]) return false;
+  for (UINT i = 0; i < N; ++i) {
+    uint16_t cell = _cells[i][lane];
+    if (cell & (cell - 1)) return false;
+  }
+  return true;
+}
+
+void BatchSolver::Scalar(const std::string& puzzle, Result& result) {
+  SudokuGrid<3> grid(puzzle);
+  BandSolver solver(grid);
+  result.unique = solver.Solve();
+  result.score = solver.GetScore();
+  result.solved = solver.GetSolvedState();
+}
+
+bool BatchSolver::Scalar(UINT lane, Result& result) {
+  if (_broken[lane]) return false;
+  uint16_t cells[N];
+  for (UINT i = 0; i < N; ++i) cells[i] = _cells[i][lane];
+  UINT count = _search.Solve(cells);
+  if (!count) return false;
+  result.unique = count == 1;
+  result.score += 100 * _search.GetGuesses();
+  _search.GetSolution(cells);
+  for (UINT i = 0; i < N; ++i) result.solved[i] = cells[i];
+  return true;
+}
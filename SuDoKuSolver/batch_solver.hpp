@@ -0,0 +1,58 @@
+//
+//  batch_solver.hpp
+//  SuDoKuSolver
+//
+//  Copyright © 2018 Hermes Productions. All rights reserved.
+//
+
+#ifndef SUDOKUSOLVER_BATCH_SOLVER_HPP
+#define SUDOKUSOLVER_BATCH_SOLVER_HPP
+
+#include "defines.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "band_solver.hpp"
+#include "grid.hpp"
+#include "lanes.hpp"
+
+// Solves 9x9 puzzles LANES at a time. Candidates are bit-sliced so each
+// cell holds one 16 bit mask per puzzle, and a cell across all puzzles is
+// a single AVX2 register (plain arrays when AVX2 is not enabled). Naked and
+// hidden singles run for every puzzle with the same vector instructions.
+// Puzzles left unsolved, or found broken, carry on in BandSearch from
+// where the batch left them, scored like the per-puzzle path.
+class BatchSolver {
+  static const UINT G = 9;
+  static const UINT N = 81;
+public:
+  static const UINT LANES = lanes::COUNT;
+  typedef SudokuGrid<3>::GridState GridState;
+  struct Result { bool unique; UINT score; GridState solved; };
+
+public:
+  BatchSolver();
+  // One result per puzzle string, as BandSolver would give it
+  void Solve(const std::vector<std::string>&, std::vector<Result>&);
+  // Puzzles from the last Solve that needed the scalar search
+  inline UINT GetBranched() const { return _branched; }
+
+private:
+  alignas(32) uint16_t _cells[N][LANES];
+  // Non-zero in lanes where propagation hit a contradiction
+  alignas(32) uint16_t _broken[LANES];
+  std::array<std::array<UINT, G>, 3 * G> _groups;
+  UINT _branched;
+  BandSearch _search;
+
+private:
+  bool Load(const std::string&, UINT);
+  void Propagate();
+  bool Solved(UINT) const;
+  void Scalar(const std::string&, Result&);
+  bool Scalar(UINT, Result&);
+};
+
+#endif /* SUDOKUSOLVER_BATCH_SOLVER_HPP */
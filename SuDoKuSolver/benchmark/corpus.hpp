@@ -0,0 +1,66 @@
+//
+//  corpus.hpp
+//  SuDoKuSolver
+//
+//  Copyright © 2018 Hermes Productions. All rights reserved.
+//
+
+#ifndef SUDOKUSOLVER_BENCHMARK_CORPUS_HPP
+#define SUDOKUSOLVER_BENCHMARK_CORPUS_HPP
+
+#include "defines.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+// Seeded puzzles for benchmarking. A full grid is made from the standard
+// pattern and shuffled with the row, column and value swaps that keep it
+// valid, then a fraction of its cells are blanked. Puzzles are not checked
+// for uniqueness, so some will have several solutions.
+template <UINT H, UINT W, UINT N = H * H * W * W>
+std::vector<std::string> MakeCorpus(UINT count, double blanks, UINT seed) {
+  static const UINT G = H * W;
+  static const char chars[] =
+    "1234567890ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+  std::mt19937 rng(seed);
+  std::vector<std::string> corpus;
+  
+  // Shuffle items in runs of size, and the runs themselves
+  auto shuffled = [&rng](UINT runs, UINT size) {
+    std::vector<UINT> order(runs), inner(size), out;
+    std::iota(order.begin(), order.end(), 0);
+    std::shuffle(order.begin(), order.end(), rng);
+    for (UINT run : order) {
+      std::iota(inner.begin(), inner.end(), run * size);
+      std::shuffle(inner.begin(), inner.end(), rng);
+      out.insert(out.end(), inner.begin(), inner.end());
+    }
+    return out;
+  };
+  
+  for (UINT p = 0; p < count; ++p) {
+    // Bands are H rows deep, stacks are W columns wide
+    std::vector<UINT> rows = shuffled(W, H), cols = shuffled(H, W);
+    std::vector<UINT> vals = shuffled(1, G);
+    std::string puzzle(N, '.');
+    for (UINT r = 0; r < G; ++r) {
+      UINT row = rows[r];
+      for (UINT c = 0; c < G; ++c) {
+        UINT val = (W * (row % H) + row / H + cols[c]) % G;
+        puzzle[r * G + c] = chars[vals[val]];
+      }
+    }
+    
+    std::vector<UINT> cells(N);
+    std::iota(cells.begin(), cells.end(), 0);
+    std::shuffle(cells.begin(), cells.end(), rng);
+    for (UINT i = 0; i < (UINT)(blanks * N); ++i) puzzle[cells[i]] = '.';
+    corpus.push_back(puzzle);
+  }
+  return corpus;
+}
+
+#endif /* SUDOKUSOLVER_BENCHMARK_CORPUS_HPP */
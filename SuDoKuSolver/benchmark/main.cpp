@@ -0,0 +1,457 @@
+//
+//  main.cpp
+//  SuDoKuSolver benchmarks
+//
+//  Copyright © 2018 Hermes Productions. All rights reserved.
+//
+
+#include "defines.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "spdlog/spdlog.h"
+
+#include "batch_solver.hpp"
+#include "cdcl_solver.hpp"
+#include "corpus.hpp"
+#include "default_solver.hpp"
+#include "dispatch.hpp"
+#include "dlx_solver.hpp"
+#include "grid.hpp"
+#include "parser.hpp"
+#include "solver.hpp"
+#include "sudoku_c.h"
+#include "suite.hpp"
+#include "validator.hpp"
+
+typedef std::chrono::steady_clock Clock;
+
+static void Usage() {
+  std::cerr << "Usage: benchmark restarts H W [count blanks seed budget]\n"
+            << "       benchmark engines [count blanks seed [H W]]\n"
+            << "       benchmark batch [count blanks seed]\n"
+            << "       benchmark check [count seed]\n"
+            << "       benchmark suite [scale [out.csv]]\n"
+            << "       benchmark compare before.csv after.csv [threshold]" << std::endl;
+}
+
+static const char* HEADER =
+  "engine         G      p50 us      p99 us     p999 us      max us";
+
+static double Micro(Clock::duration d) {
+  return std::chrono::duration<double, std::micro>(d).count();
+}
+
+// Print the quantiles of a set of solve times in microseconds
+static void Report(const std::string& name, UINT g, std::vector<double>& t) {
+  std::sort(t.begin(), t.end());
+  auto quantile = [&t](double q) {
+    return t[std::min(t.size() - 1, (size_t)(q * t.size()))];
+  };
+  std::cout << std::left << std::setw(12) << name << std::right
+  << std::setw(4) << g << std::fixed << std::setprecision(1)
+  << std::setw(12) << quantile(0.5) << std::setw(12) << quantile(0.99)
+  << std::setw(12) << quantile(0.999) << std::setw(12) << t.back()
+  << std::endl;
+}
+
+// Compare deterministic brute force search to the restarting search
+template <UINT H, UINT W, UINT N>
+int Restarts(UINT count, double blanks, UINT seed, UINT budget) {
+  std::vector<std::string> corpus = MakeCorpus<H,W,N>(count, blanks, seed);
+  std::vector<double> plain, restart;
+  UINT mismatches = 0;
+  for (UINT i = 0; i < corpus.size(); ++i) {
+    SudokuGrid<H,W,N> grid(corpus[i]);
+    BruteForceSolver<H,W,N> a(grid), b(grid);
+    b.UseRestarts(seed + i, budget);
+    
+    Clock::time_point start = Clock::now();
+    bool unique_a = a.Solve();
+    Clock::time_point mid = Clock::now();
+    bool unique_b = b.Solve();
+    Clock::time_point end = Clock::now();
+    
+    if (unique_a != unique_b) ++mismatches;
+    plain.push_back(Micro(mid - start));
+    restart.push_back(Micro(end - mid));
+  }
+  std::cout << HEADER << std::endl;
+  Report("brute", H * W, plain);
+  Report("restarts", H * W, restart);
+  if (mismatches) std::cerr << mismatches << " puzzles disagree" << std::endl;
+  return mismatches ? 1 : 0;
+}
+
+// Whether each puzzle had a unique solution, and the solution found
+template <UINT H, UINT W, UINT N>
+using Answers = std::vector<std::pair<bool, typename SudokuGrid<H,W,N>::GridState>>;
+
+// Time one engine over a corpus, keeping the answers to compare
+template <UINT H, UINT W, UINT N, class Solver>
+double TimeEngine(const std::vector<std::string>& corpus, const char* name,
+                  Answers<H,W,N>& out) {
+  std::vector<double> times;
+  double total = 0;
+  out.clear();
+  for (const std::string& puzzle : corpus) {
+    SudokuGrid<H,W,N> grid(puzzle);
+    Solver solver(grid);
+    Clock::time_point start = Clock::now();
+    bool unique = solver.Solve();
+    times.push_back(Micro(Clock::now() - start));
+    total += times.back();
+    out.emplace_back(unique, solver.GetSolvedState());
+  }
+  Report(name, H * W, times);
+  return total;
+}
+
+// Compare the complete search engines, naming the fastest in total
+template <UINT H, UINT W, UINT N>
+int Engines(UINT count, double blanks, UINT seed) {
+  std::vector<std::string> corpus = MakeCorpus<H,W,N>(count, blanks, seed);
+  Answers<H,W,N> brute, dlx, cdcl;
+  double brute_total =
+    TimeEngine<H,W,N,BruteForceSolver<H,W,N>>(corpus, "brute", brute);
+  double dlx_total =
+    TimeEngine<H,W,N,DancingLinksSolver<H,W,N>>(corpus, "dlx", dlx);
+  double cdcl_total =
+    TimeEngine<H,W,N,CdclSolver<H,W,N>>(corpus, "cdcl", cdcl);
+  // Sizes with a specialised engine time it as well
+  typedef typename DefaultSolver<H,W,N>::type Default;
+  bool specialised = !std::is_same<Default, BruteForceSolver<H,W,N>>::value;
+  Answers<H,W,N> special = brute;
+  double special_total = specialised ?
+    TimeEngine<H,W,N,Default>(corpus, "default", special) : brute_total;
+  
+  UINT mismatches = 0;
+  for (UINT i = 0; i < corpus.size(); ++i) {
+    auto differs = [&brute, i](const typename Answers<H,W,N>::value_type& r) {
+      return r.first != brute[i].first || (r.first && r.second != brute[i].second);
+    };
+    if (differs(dlx[i]) || differs(cdcl[i]) || differs(special[i])) ++mismatches;
+  }
+  const char* fastest = "brute";
+  double best = brute_total;
+  if (dlx_total < best) { fastest = "dlx"; best = dlx_total; }
+  if (cdcl_total < best) { fastest = "cdcl"; best = cdcl_total; }
+  if (special_total < best) fastest = "default";
+  std::cout << "fastest      " << std::setw(3) << H * W << "  " << fastest
+            << std::endl;
+  if (mismatches) std::cerr << mismatches << " puzzles disagree" << std::endl;
+  return mismatches ? 1 : 0;
+}
+
+// 9x9 puzzles per second through the generic search, the grid's default
+// engine one puzzle at a time, and SIMD batches
+int Batch(UINT count, double blanks, UINT seed) {
+  std::vector<std::string> corpus = MakeCorpus<3,3,81>(count, blanks, seed);
+  std::vector<BatchSolver::Result> single(corpus.size()), batched;
+  
+  Clock::time_point start = Clock::now();
+  for (const std::string& puzzle : corpus) {
+    SudokuGrid<3> grid(puzzle);
+    BruteForceSolver<3> solver(grid);
+    solver.Solve();
+  }
+  Clock::time_point brute_end = Clock::now();
+  for (UINT i = 0; i < corpus.size(); ++i) {
+    SudokuGrid<3> grid(corpus[i]);
+    DefaultSolver<3,3,81>::type solver(grid);
+    single[i].unique = solver.Solve();
+    single[i].score = solver.GetScore();
+    single[i].solved = solver.GetSolvedState();
+  }
+  Clock::time_point single_end = Clock::now();
+  BatchSolver batch;
+  batch.Solve(corpus, batched);
+  Clock::time_point end = Clock::now();
+  
+  UINT mismatches = 0;
+  for (UINT i = 0; i < corpus.size(); ++i) {
+    if (single[i].unique != batched[i].unique || single[i].score != batched[i].score
+        || single[i].solved != batched[i].solved) ++mismatches;
+  }
+  auto rate = [&corpus](Clock::duration d) {
+    return corpus.size() / std::chrono::duration<double>(d).count();
+  };
+  std::cout << "path        puzzles/s" << std::endl << std::fixed
+  << std::setprecision(0) << "brute    " << std::setw(12)
+  << rate(brute_end - start) << std::endl << "single   " << std::setw(12)
+  << rate(single_end - brute_end) << std::endl << "batch    " << std::setw(12)
+  << rate(end - single_end) << "  (" << batch.GetBranched() << " of "
+  << corpus.size() << " branched, "
+#ifdef __AVX2__
+  << "avx2)"
+#else
+  << "scalar)"
+#endif
+  << std::endl;
+  if (mismatches) std::cerr << mismatches << " puzzles disagree" << std::endl;
+  return mismatches ? 1 : 0;
+}
+
+// SolutionValidator, directly and through the C interface, against
+// SudokuGrid on complete grids, each as made, with two cells of a row
+// swapped, and with a clue of its puzzle changed
+template <UINT H, UINT W, UINT N>
+UINT CheckSolutions(UINT size, UINT count, UINT seed) {
+  static const UINT G = H * W;
+  std::vector<std::string> grids = MakeCorpus<H,W,N>(count, 0, seed);
+  std::mt19937 rng(seed);
+  std::string solutions, puzzles;
+  std::vector<bool> expected;
+  for (const std::string& grid : grids) {
+    std::string puzzle = grid;
+    for (UINT i = 0; i < N; ++i) if (rng() % 2) puzzle[i] = '.';
+    for (UINT copy = 0; copy < 3; ++copy) {
+      std::string solution = grid, clues = puzzle;
+      if (copy == 1) {
+        UINT row = rng() % G, a = rng() % G, b = (a + 1 + rng() % (G - 1)) % G;
+        std::swap(solution[row * G + a], solution[row * G + b]);
+      } else if (copy == 2) {
+        UINT i = rng() % N;
+        clues[i] = solution[i] == CellChar(1) ? CellChar(2) : CellChar(1);
+      }
+      ParseResult parsed, given_parsed;
+      SudokuGrid<H,W,N> solved(solution, PuzzleDialect::Default(), parsed);
+      SudokuGrid<H,W,N> given(clues, PuzzleDialect::Default(), given_parsed);
+      bool valid = parsed.error == ParseError::NONE && solved.IsSolved();
+      for (UINT i = 0; valid && i < N; ++i) {
+        const typename SudokuGrid<H,W,N>::Cell& clue = given.GetCell(i);
+        if (clue.IsFixed()) valid = clue.GetValue() == solved.GetCell(i).GetValue();
+      }
+      expected.push_back(valid);
+      solutions += solution;
+      puzzles += clues;
+    }
+  }
+  std::vector<SolutionCheck> checks(expected.size());
+  SolutionValidator validator(size);
+  validator.Validate(solutions.data(), puzzles.data(), expected.size(), checks.data());
+  std::vector<sudoku_result_t> results(expected.size());
+  sudoku_validate_batch((int)size, solutions.data(), puzzles.data(), expected.size(),
+                        results.data());
+  UINT mismatches = 0;
+  for (UINT i = 0; i < expected.size(); ++i) {
+    if (expected[i] != (checks[i].error == SolutionError::NONE) ||
+        expected[i] != (results[i].status == SUDOKU_SOLVED)) ++mismatches;
+  }
+  std::cout << "solutions  " << std::setw(4) << G << std::setw(8) << expected.size()
+            << std::setw(8) << std::count(expected.begin(), expected.end(), true)
+            << std::setw(8) << mismatches << std::endl;
+  return mismatches;
+}
+
+// Player edits placed and cleared one at a time, clearing the first made
+// so later ones are replayed. After each, the grid must match one with the
+// same placements made from scratch, and a grid read with them as clues
+// for whether they clash and whether the puzzle can still be solved.
+template <UINT H, UINT W, UINT N>
+UINT CheckEdits(UINT count, UINT seed) {
+  static const UINT G = H * W;
+  typedef SudokuGrid<H,W,N> Grid;
+  std::vector<std::string> corpus =
+    MakeCorpus<H,W,N>(std::min(count, suite::Count(N, 0.05)), suite::Blanks(G, 0), seed);
+  std::mt19937 rng(seed);
+  UINT cases = 0, solvable = 0, mismatches = 0;
+  for (const std::string& puzzle : corpus) {
+    Grid grid(puzzle);
+    const typename Grid::GridState initial = grid.GetCurrentState();
+    const typename Grid::GridState solution = grid.GetSolvedState();
+    const bool unique = grid.IsSolvable();
+    std::vector<std::pair<UINT, UINT>> placed;
+    auto compare = [&] {
+      Grid replayed(puzzle);
+      std::string edited = puzzle;
+      for (auto& p : placed) {
+        replayed.Place(p.first, p.second);
+        edited[p.first] = CellChar(p.second);
+      }
+      ParseResult parsed;
+      Grid read(edited, PuzzleDialect::Default(), parsed);
+      bool valid = parsed.error == ParseError::NONE;
+      bool can_solve = unique && valid && read.IsSolvable();
+      ++cases;
+      solvable += can_solve;
+      if (grid.GetCurrentState() != replayed.GetCurrentState() ||
+          grid.EditsValid() != replayed.EditsValid() || grid.EditsValid() != valid ||
+          grid.EditsSolvable() != can_solve) ++mismatches;
+    };
+    
+    std::vector<UINT> blanks;
+    for (UINT i = 0; i < N; ++i) if (puzzle[i] == '.') blanks.push_back(i);
+    std::shuffle(blanks.begin(), blanks.end(), rng);
+    // Mostly right values while the puzzle has one solution, so clears
+    // move between solvable and not
+    for (UINT i = 0; i < std::min((UINT)blanks.size(), (UINT)6); ++i) {
+      UINT v = unique && rng() % 3 ? __find_first(_AT(solution, blanks[i])) + 1
+                                   : rng() % G + 1;
+      grid.Place(blanks[i], v);
+      placed.emplace_back(blanks[i], v);
+      compare();
+    }
+    for (bool first = true; !placed.empty(); first = false) {
+      UINT k = first ? 0 : rng() % placed.size();
+      grid.Clear(placed[k].first);
+      placed.erase(placed.begin() + k);
+      compare();
+    }
+    if (grid.GetCurrentState() != initial) ++mismatches;
+  }
+  std::cout << "edits      " << std::setw(4) << G << std::setw(8) << cases
+            << std::setw(8) << solvable << std::setw(8) << mismatches << std::endl;
+  return mismatches;
+}
+
+// DetectSize on records with and without headers, including headerless
+// ones whose metadata holds colons, as solveable_dat.txt lines do
+UINT CheckHeaders() {
+  const PuzzleDialect dialect(".", "", true);
+  const std::string nine(81, '.'), four(16, '.');
+  UINT NINE = 0, FOUR = 0;
+  for (UINT i = 0; i < NUM_GRID_SIZES; ++i) {
+    if (GRID_SIZES[i].n == 81) NINE = i;
+    if (GRID_SIZES[i].n == 16) FOUR = i;
+  }
+  const std::pair<std::string, UINT> records[] = {
+    {nine, NINE},
+    {"3x3:" + nine, NINE},
+    {nine + " # 000::012::345 30 51", NINE},
+    {nine + " id:42", NINE},
+    {"3x3:" + nine + " id:42", NINE},
+    {four + " a:b", FOUR},
+    {"2x3:" + nine, NUM_GRID_SIZES},
+    {"3y3:" + nine, NUM_GRID_SIZES},
+  };
+  UINT cases = 0, pass = 0, mismatches = 0;
+  for (const auto& record : records) {
+    std::string_view cells;
+    UINT size = DetectSize(record.first, cells, dialect);
+    ++cases;
+    bool found = size != NUM_GRID_SIZES;
+    pass += found;
+    if (size != record.second || (found && cells.size() != GRID_SIZES[size].n))
+      ++mismatches;
+  }
+  std::cout << "headers       -" << std::setw(8) << cases << std::setw(8) << pass
+            << std::setw(8) << mismatches << std::endl;
+  return mismatches;
+}
+
+// Checks of the fast paths against the grid they stand in for
+template <UINT H, UINT W, UINT N>
+int Check(UINT size, UINT count, UINT seed) {
+  UINT mismatches = CheckSolutions<H,W,N>(size, count, seed);
+  mismatches += CheckEdits<H,W,N>(count, seed);
+  return mismatches ? 1 : 0;
+}
+
+int main(int argc, const char * argv[]) {
+  auto log = spdlog::stderr_logger_st("logger");
+  if (argc < 2) {
+    Usage();
+    return 1;
+  }
+  std::string mode = argv[1];
+  
+  if (mode == "restarts" && argc >= 4) {
+    UINT h = std::atoi(argv[2]), w = std::atoi(argv[3]);
+    UINT count = argc > 4 ? std::atoi(argv[4]) : 1000;
+    double blanks = argc > 5 ? std::atof(argv[5]) : 0.6;
+    UINT seed = argc > 6 ? std::atoi(argv[6]) : 1;
+    UINT budget = argc > 7 ? std::atoi(argv[7]) : 64;
+#define GRID_SIZE(x,y,z)\
+    if (h == x && w == y) return Restarts<x,y,z>(count, blanks, seed, budget);
+#include "gridsizes.itm"
+#undef GRID_SIZE
+  }
+  
+  if (mode == "engines") {
+    // Every grid size unless one is given, so each can be routed to its
+    // fastest engine
+    UINT count = argc > 2 ? std::atoi(argv[2]) : 100;
+    double blanks = argc > 3 ? std::atof(argv[3]) : 0.5;
+    UINT seed = argc > 4 ? std::atoi(argv[4]) : 1;
+    UINT h = argc > 6 ? std::atoi(argv[5]) : 0, w = argc > 6 ? std::atoi(argv[6]) : 0;
+    int failed = 0;
+    std::cout << HEADER << std::endl;
+#define GRID_SIZE(x,y,z)\
+    if (!h || (h == x && w == y)) failed |= Engines<x,y,z>(count, blanks, seed);
+#include "gridsizes.itm"
+#undef GRID_SIZE
+    return failed;
+  }
+  
+  if (mode == "check") {
+    UINT count = argc > 2 ? std::atoi(argv[2]) : 100;
+    UINT seed = argc > 3 ? std::atoi(argv[3]) : 1;
+    UINT size = 0;
+    int failed = 0;
+    std::cout << "check         G   cases    pass  differ" << std::endl;
+#define GRID_SIZE(x,y,z)\
+    failed |= Check<x,y,z>(size++, count, seed);
+#include "gridsizes.itm"
+#undef GRID_SIZE
+    if (CheckHeaders()) failed = 1;
+    if (failed) std::cerr << "Fast paths disagree with SudokuGrid" << std::endl;
+    return failed;
+  }
+  
+  if (mode == "batch") {
+    UINT count = argc > 2 ? std::atoi(argv[2]) : 100000;
+    double blanks = argc > 3 ? std::atof(argv[3]) : 0.6;
+    UINT seed = argc > 4 ? std::atoi(argv[4]) : 1;
+    return Batch(count, blanks, seed);
+  }
+  
+  if (mode == "suite") {
+    // CSV on stdout unless a file is given
+    double scale = argc > 2 ? std::atof(argv[2]) : 1.0;
+#ifndef USE_INSTRUMENTATION
+    std::cerr << "Warning: built without USE_INSTRUMENTATION, so the technique/ and "
+              << "handle_actions rows are left out" << std::endl;
+#endif
+    SuiteRecords records = RunSuite(scale);
+    if (argc > 3) {
+      std::ofstream out(argv[3]);
+      WriteSuite(out, records);
+    } else WriteSuite(std::cout, records);
+    return 0;
+  }
+  
+  if (mode == "compare" && argc >= 4) {
+    std::ifstream before_file(argv[2]), after_file(argv[3]);
+    std::map<std::string, SuiteRecord> before, after;
+    std::string before_build, after_build;
+    if (!ReadSuite(before_file, before, before_build) ||
+        !ReadSuite(after_file, after, after_build)) {
+      std::cerr << "Both files must be output from benchmark suite" << std::endl;
+      return 1;
+    }
+    double threshold = argc > 4 ? std::atof(argv[4]) : 0.1;
+    // Technique rows only exist in instrumented runs, and instrumentation
+    // slows everything else, so the runs can't be compared
+    std::string was = BuildSetting(before_build, "instrumentation");
+    std::string now = BuildSetting(after_build, "instrumentation");
+    if (was != now) {
+      std::cerr << "Instrumentation differs (" << was << " before, " << now
+                << " after), so the suites can't be compared" << std::endl;
+      return 2;
+    }
+    return CompareSuites(before, after, threshold, std::cout) ? 2 : 0;
+  }
+  
+  Usage();
+  return 1;
+}
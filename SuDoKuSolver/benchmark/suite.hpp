@@ -0,0 +1,295 @@
+//
+//  suite.hpp
+//  SuDoKuSolver
+//
+//  Copyright © 2018 Hermes Productions. All rights reserved.
+//
+
+#ifndef SUDOKUSOLVER_BENCHMARK_SUITE_HPP
+#define SUDOKUSOLVER_BENCHMARK_SUITE_HPP
+
+#include "defines.hpp"
+
+#include <algorithm>
+#include <bitset>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "EASTL/bitset.h"
+
+#include "corpus.hpp"
+#include "default_solver.hpp"
+#include "grid.hpp"
+#include "solver.hpp"
+
+// One benchmark result. median_ns is per operation timed; technique rows
+// are only timed in aggregate by the instrumentation, so they carry the
+// mean per call there and no p99.
+struct SuiteRecord {
+  std::string name;
+  UINT size;
+  std::string bucket;
+  UINT samples;
+  double median_ns, mean_ns, p99_ns;
+};
+
+typedef std::vector<SuiteRecord> SuiteRecords;
+
+namespace suite {
+  typedef std::chrono::steady_clock Clock;
+
+  inline double Nanos(Clock::duration d) {
+    return std::chrono::duration<double, std::nano>(d).count();
+  }
+
+  inline void Summarise(SuiteRecords& out, const std::string& name, UINT size,
+                        const std::string& bucket, std::vector<double>& times) {
+    if (times.empty()) return;
+    std::sort(times.begin(), times.end());
+    double total = 0;
+    for (double t : times) total += t;
+    out.push_back({name, size, bucket, (UINT)times.size(), times[times.size() / 2],
+                   total / times.size(),
+                   times[std::min(times.size() - 1, (size_t)(0.99 * times.size()))]});
+  }
+
+  // Difficulty buckets blank a fraction of the hardest level for the size.
+  // The hardest level shrinks with size to stay where brute force finishes
+  // in milliseconds.
+  const char* const BUCKETS[] = {"easy", "medium", "hard"};
+  inline double Blanks(UINT g, UINT bucket) {
+    double hardest = g <= 16 ? 0.6 : g <= 25 ? 0.45 : g <= 36 ? 0.4 : 0.35;
+    return hardest * (0.5 + 0.25 * bucket);
+  }
+
+  // Enough puzzles for stable medians, fewer as grids get larger
+  inline UINT Count(UINT n, double scale) {
+    return std::max((UINT)5, (UINT)(scale * 40000 / n));
+  }
+
+  // Scan bits as utility.hpp does for each backend
+  template <size_t B>
+  inline UINT FirstSet(const std::bitset<B>& bs) {
+    if (bs.none()) return B;
+    UINT idx = 0;
+    while (!bs[idx]) ++idx;
+    return idx;
+  }
+  template <size_t B>
+  inline UINT NextSet(const std::bitset<B>& bs, UINT pos) {
+    UINT idx = pos + 1;
+    while (idx < B && !bs[idx]) ++idx;
+    return idx;
+  }
+  template <size_t B>
+  inline UINT FirstSet(const eastl::bitset<B>& bs) { return bs.find_first(); }
+  template <size_t B>
+  inline UINT NextSet(const eastl::bitset<B>& bs, UINT pos) { return bs.find_next(pos); }
+
+  // The operations the solvers lean on, over a fixed random set of masks
+  template <class Bitset, UINT B>
+  void BitsetRows(SuiteRecords& out, const char* backend, UINT g, UINT repeats) {
+    const UINT MASKS = 1024;
+    std::mt19937 rng(B);
+    std::vector<Bitset> masks(MASKS);
+    for (Bitset& m : masks) {
+      for (UINT i = 0; i < B; ++i) if (rng() % 10 < 3) m.set(i);
+    }
+    std::vector<double> counting, iterating;
+    volatile UINT sink = 0;
+    for (UINT r = 0; r < repeats; ++r) {
+      Clock::time_point start = Clock::now();
+      UINT sum = 0;
+      for (UINT i = 0; i < MASKS; ++i) sum += (masks[i] & ~masks[(i + 1) % MASKS]).count();
+      Clock::time_point mid = Clock::now();
+      for (const Bitset& m : masks) {
+        for (UINT i = FirstSet(m); i < B; i = NextSet(m, i)) sum += i;
+      }
+      Clock::time_point end = Clock::now();
+      sink = sink + sum;
+      counting.push_back(Nanos(mid - start) / MASKS);
+      iterating.push_back(Nanos(end - mid) / MASKS);
+    }
+    Summarise(out, std::string("bitset/") + backend + "/and_not_count", g, "all", counting);
+    Summarise(out, std::string("bitset/") + backend + "/iterate", g, "all", iterating);
+  }
+
+  // Every benchmark for one grid size
+  template <UINT H, UINT W, UINT N>
+  void Size(SuiteRecords& out, double scale) {
+    static const UINT G = H * W;
+    typedef typename DefaultSolver<H,W,N>::type Default;
+    const bool specialised = !std::is_same<Default, BruteForceSolver<H,W,N>>::value;
+    for (UINT b = 0; b < 3; ++b) {
+      const std::string bucket = BUCKETS[b];
+      std::vector<std::string> corpus =
+        MakeCorpus<H,W,N>(Count(N, scale), Blanks(G, b), (UINT)(1000 * G + b));
+      std::vector<double> construct, brute, special;
+      for (const std::string& puzzle : corpus) {
+        Clock::time_point start = Clock::now();
+        SudokuGrid<H,W,N> grid(puzzle);
+        construct.push_back(Nanos(Clock::now() - start));
+
+        BruteForceSolver<H,W,N> solver(grid);
+        start = Clock::now();
+        solver.Solve();
+        brute.push_back(Nanos(Clock::now() - start));
+
+        if (!specialised) continue;
+        Default engine(grid);
+        start = Clock::now();
+        engine.Solve();
+        special.push_back(Nanos(Clock::now() - start));
+      }
+      Summarise(out, "grid/construct", G, bucket, construct);
+      Summarise(out, "solve/brute", G, bucket, brute);
+      Summarise(out, "solve/default", G, bucket, special);
+
+      // Pattern overlay enumerates every placement of a value, which only
+      // stays affordable up to 9x9
+      if (G > 9) continue;
+      std::vector<double> logical;
+      Instruments instruments;
+      for (UINT i = 0; i < corpus.size(); i += 4) {
+        SudokuGrid<H,W,N> grid(corpus[i]);
+        LogicalSolver<H,W,N> solver(grid);
+        Clock::time_point start = Clock::now();
+        solver.Solve();
+        logical.push_back(Nanos(Clock::now() - start));
+        instruments += solver.GetInstruments();
+      }
+      Summarise(out, "solve/logical", G, bucket, logical);
+      for (UINT op = 0; op <= NUM_OPERATIONS; ++op) {
+        const TechniqueStats& t = op < NUM_OPERATIONS ?
+          instruments.Get((LogicOperation)op) : instruments.Actions();
+        if (!t.calls) continue;
+        double mean = (double)t.nanoseconds / t.calls;
+        std::string name = op < NUM_OPERATIONS ? OperationName((LogicOperation)op)
+                                               : "handle_actions";
+        out.push_back({"technique/" + name, G, bucket, (UINT)t.calls, mean, mean, 0});
+      }
+    }
+  }
+}
+
+// Runs everything, over corpora that are the same on every run. Scale
+// multiplies the number of puzzles.
+inline SuiteRecords RunSuite(double scale) {
+  SuiteRecords records;
+#define GRID_SIZE(x,y,z)\
+  suite::Size<x,y,z>(records, scale);
+#include "gridsizes.itm"
+#undef GRID_SIZE
+  UINT repeats = std::max((UINT)5, (UINT)(scale * 50));
+  suite::BitsetRows<std::bitset<81>, 81>(records, "std", 9, repeats);
+  suite::BitsetRows<eastl::bitset<81>, 81>(records, "eastl", 9, repeats);
+  suite::BitsetRows<std::bitset<256>, 256>(records, "std", 16, repeats);
+  suite::BitsetRows<eastl::bitset<256>, 256>(records, "eastl", 16, repeats);
+  return records;
+}
+
+// CSV, after comment lines saying how the solvers were built
+inline std::ostream& WriteSuite(std::ostream& s, const SuiteRecords& records) {
+  s << "# bitset="
+#ifdef USE_EASTL_BITSET
+  << "eastl"
+#else
+  << "std"
+#endif
+  << " simd="
+#ifdef __AVX2__
+  << "avx2"
+#else
+  << "none"
+#endif
+  << " instrumentation="
+#ifdef USE_INSTRUMENTATION
+  << "on"
+#else
+  << "off"
+#endif
+  << "\nbenchmark,size,bucket,samples,median_ns,mean_ns,p99_ns\n"
+  << std::fixed << std::setprecision(1);
+  for (const SuiteRecord& r : records) {
+    s << r.name << "," << r.size << "," << r.bucket << "," << r.samples << ","
+    << r.median_ns << "," << r.mean_ns << "," << r.p99_ns << "\n";
+  }
+  return s << std::flush;
+}
+
+// Records keyed by benchmark, size and bucket, and the comment line saying
+// how the solvers were built. Returns false if the input isn't a suite CSV.
+inline bool ReadSuite(std::istream& s, std::map<std::string, SuiteRecord>& out,
+                      std::string& build) {
+  std::string line;
+  bool header = false;
+  while (std::getline(s, line)) {
+    if (line.compare(0, 8, "# bitset") == 0) build = line;
+    if (line.empty() || line[0] == '#') continue;
+    if (!header) {
+      if (line.compare(0, 10, "benchmark,") != 0) return false;
+      header = true;
+      continue;
+    }
+    std::stringstream ss(line);
+    std::vector<std::string> fields;
+    std::string field;
+    while (std::getline(ss, field, ',')) fields.push_back(field);
+    if (fields.size() != 7) return false;
+    SuiteRecord r{fields[0], (UINT)std::stoul(fields[1]), fields[2],
+      (UINT)std::stoul(fields[3]), std::stod(fields[4]), std::stod(fields[5]),
+      std::stod(fields[6])};
+    out[r.name + "," + fields[1] + "," + r.bucket] = r;
+  }
+  return header;
+}
+
+// A setting from a build line, such as "on" for "instrumentation"
+inline std::string BuildSetting(const std::string& build, const std::string& key) {
+  size_t at = build.find(" " + key + "=");
+  if (at == std::string::npos) return "";
+  at += key.size() + 2;
+  return build.substr(at, build.find(' ', at) - at);
+}
+
+// Median change of every benchmark in both runs, flagging those slower by
+// more than threshold (0.1 is 10%). Returns the number of regressions.
+inline UINT CompareSuites(const std::map<std::string, SuiteRecord>& before,
+                          const std::map<std::string, SuiteRecord>& after,
+                          double threshold, std::ostream& s) {
+  UINT regressions = 0;
+  s << std::left << std::setw(44) << "benchmark,size,bucket" << std::right
+  << std::setw(14) << "before ns" << std::setw(14) << "after ns"
+  << std::setw(10) << "change" << "\n" << std::fixed;
+  for (auto& b : before) {
+    auto a = after.find(b.first);
+    if (a == after.end()) {
+      s << std::left << std::setw(44) << b.first << std::right << "  missing\n";
+      continue;
+    }
+    double was = b.second.median_ns, now = a->second.median_ns;
+    double change = was > 0 ? now / was - 1 : 0;
+    bool regressed = change > threshold;
+    if (regressed) ++regressions;
+    s << std::left << std::setw(44) << b.first << std::right << std::setprecision(1)
+    << std::setw(14) << was << std::setw(14) << now << std::setw(9)
+    << std::showpos << 100 * change << std::noshowpos << "%"
+    << (regressed ? "  REGRESSION" : "") << "\n";
+  }
+  for (auto& a : after) {
+    if (!before.count(a.first))
+      s << std::left << std::setw(44) << a.first << std::right << "  new\n";
+  }
+  s << regressions << " regression" << (regressions == 1 ? "" : "s")
+  << " over " << std::setprecision(0) << 100 * threshold << "%" << std::endl;
+  return regressions;
+}
+
+#endif /* SUDOKUSOLVER_BENCHMARK_SUITE_HPP */
@@ -0,0 +1,468 @@
+//
+//  cdcl_solver.cpp
+//  SuDoKuSolver
+//
+//  Copyright © 2018 Hermes Productions. All rights reserved.
+//
+
+#include "defines.hpp"
+#include <algorithm>
+#include <vector>
+
+#include "cdcl_solver.hpp"
+#include "grid.hpp"
+#include "utility.hpp"
+
+// Variable heap implementation
+void VarHeap::Reset(UINT vars) {
+  _heap.clear();
+  _index.assign(vars, ~UINT(0));
+}
+
+void VarHeap::Insert(UINT v) {
+  _index[v] = _heap.size();
+  _heap.push_back(v);
+  Up(_index[v]);
+}
+
+void VarHeap::Increased(UINT v) {
+  Up(_index[v]);
+}
+
+UINT VarHeap::Pop() {
+  UINT top = _heap.front();
+  _index[top] = ~UINT(0);
+  UINT last = _heap.back();
+  _heap.pop_back();
+  if (_heap.size()) {
+    _heap.front() = last;
+    _index[last] = 0;
+    Down(0);
+  }
+  return top;
+}
+
+void VarHeap::Up(UINT i) {
+  UINT v = _heap[i];
+  while (i > 0) {
+    UINT parent = (i - 1) / 2;
+    if (_activity[_heap[parent]] >= _activity[v]) break;
+    _heap[i] = _heap[parent];
+    _index[_heap[i]] = i;
+    i = parent;
+  }
+  _heap[i] = v;
+  _index[v] = i;
+}
+
+void VarHeap::Down(UINT i) {
+  UINT v = _heap[i];
+  while (2 * i + 1 < _heap.size()) {
+    UINT child = 2 * i + 1;
+    if (child + 1 < _heap.size()
+        && _activity[_heap[child + 1]] > _activity[_heap[child]]) ++child;
+    if (_activity[_heap[child]] <= _activity[v]) break;
+    _heap[i] = _heap[child];
+    _index[_heap[i]] = i;
+    i = child;
+  }
+  _heap[i] = v;
+  _index[v] = i;
+}
+
+// CDCL solver implementation
+template <UINT H, UINT W, UINT N>
+const UINT CdclSolver<H,W,N>::NONE;
+
+template <UINT H, UINT W, UINT N>
+CdclSolver<H,W,N>::CdclSolver(SudokuGrid<H,W,N>& grid)
+: ISudokuSolver<H,W,N>(grid), _heap(_activity), _max(2), _count(0),
+_score(0), _unsolved(0), _conflicts(0), _decisions(0), _learnts(0),
+_max_learnts(0)
+{
+  for (UINT i = 0; i < N; ++i) {
+    FORBITSIN(peer, _AT(this->_affected, i)) _AT(_peers, i).push_back(peer);
+  }
+}
+
+template <UINT H, UINT W, UINT N>
+bool CdclSolver<H,W,N>::Solve() {
+  _count = 0;
+  _max = 2;
+  _conflicts = 0;
+  _decisions = 0;
+  if (!Initialise()) return this->Finish(false);
+  
+  UINT restart = 1, budget = 100 * Luby(restart);
+  while (true) {
+    if (!Propagate()) {
+      ++_conflicts;
+      if (!Level()) break;  // Nothing left to try
+      UINT level;
+      Analyse(level);
+      Backtrack(level);
+      if (_learnt.size() == 1) Enqueue(_learnt[0], NONE, NONE);
+      else Enqueue(_learnt[0], AddClause(_learnt, true), NONE);
+      _var_inc /= 0.95;
+      _clause_inc /= 0.999;
+      if (--budget == 0) {
+        Backtrack(0);
+        budget = 100 * Luby(++restart);
+      }
+      continue;
+    }
+    if (_learnts > _max_learnts) ReduceLearnt();
+    
+    // Branch on the most active unassigned variable, setting it true
+    UINT var = NONE;
+    while (!_heap.Empty() && var == NONE) {
+      UINT v = _heap.Pop();
+      if (!_values[v]) var = v;
+    }
+    if (var == NONE) {
+      // Everything assigned without conflict, so this is a solution
+      ++_count;
+      for (UINT i = 0; i < N; ++i) {
+        Values& cell = _AT(this->_solved, i);
+        cell.reset();
+        for (UINT val = 0; val < G; ++val) {
+          if (_values[i * G + val] == 1) cell.set(val);
+        }
+      }
+      _score += 100 * Level();
+      if (_count == _max || !BlockSolution()) break;  // bail out
+      continue;
+    }
+    _levels.push_back(_trail.size());
+    ++_decisions;
+    Enqueue(var << 1, NONE, NONE);
+  }
+  return this->Finish(_count == 1);
+}
+
+template <UINT H, UINT W, UINT N>
+bool CdclSolver<H,W,N>::Initialise() {
+  const UINT vars = N * G;
+  _values.assign(vars, 0);
+  _vars.assign(vars, Assignment{0, NONE, NONE});
+  _trail.clear();
+  _levels.clear();
+  _queue = 0;
+  _clauses.clear();
+  _lits.clear();
+  _watches.assign(2 * vars, std::vector<UINT>());
+  _activity.assign(vars, 0);
+  _var_inc = _clause_inc = 1;
+  _seen.assign(vars, false);
+  _heap.Reset(vars);
+  _learnts = 0;
+  _score = _unsolved = 0;
+  
+  // Values ruled out by the initial state are false and clues are true.
+  // Everything else goes in the heap, cells with fewer options first.
+  for (UINT i = 0; i < N; ++i) {
+    const Values& options = _AT(this->_initial, i);
+    bool fixed = this->_grid.GetCell(i).IsFixed();
+    if (!fixed) ++_unsolved;
+    for (UINT val = 0; val < G; ++val) {
+      UINT var = i * G + val;
+      if (!options[val]) Enqueue((var << 1) | 1, NONE, NONE);
+      else if (fixed) Enqueue(var << 1, NONE, NONE);
+      else {
+        _activity[var] = 1e-3 / options.count();
+        _heap.Insert(var);
+      }
+    }
+  }
+  _score = _unsolved;
+  
+  // At least one value per cell and one place per (group, value)
+  std::vector<UINT> clause;
+  auto add = [this](const std::vector<UINT>& lits) {
+    if (lits.empty()) return false;
+    if (lits.size() == 1) Enqueue(lits[0], NONE, NONE);
+    else AddClause(lits, false);
+    return true;
+  };
+  for (UINT i = 0; i < N; ++i) {
+    if (this->_grid.GetCell(i).IsFixed()) continue;
+    clause.clear();
+    FORBITSIN(val, _AT(this->_initial, i)) clause.push_back((i * G + val) << 1);
+    if (!add(clause)) return false;
+  }
+  for (const AllCells& group : this->_groups) {
+    if (group.count() != G) continue;
+    Values placed(0);
+    FORBITSIN(idx, group) {
+      if (this->_grid.GetCell(idx).IsFixed()) placed |= _AT(this->_initial, idx);
+    }
+    for (UINT val = 0; val < G; ++val) {
+      if (placed[val]) continue;
+      clause.clear();
+      FORBITSIN(idx, group) {
+        if (_AT(this->_initial, idx)[val]) clause.push_back((idx * G + val) << 1);
+      }
+      if (!add(clause)) return false;
+    }
+  }
+  _max_learnts = _clauses.size() / 3 + 1000;
+  return Propagate();
+}
+
+template <UINT H, UINT W, UINT N>
+void CdclSolver<H,W,N>::Enqueue(UINT lit, UINT clause, UINT implied_by) {
+  UINT var = lit >> 1;
+  _values[var] = (lit & 1) ? -1 : 1;
+  _vars[var] = Assignment{Level(), clause, implied_by};
+  _trail.push_back(lit);
+}
+
+template <UINT H, UINT W, UINT N>
+bool CdclSolver<H,W,N>::Falsify(UINT lit, UINT implied_by) {
+  // Make lit false because implied_by is true. Conflict if lit already is.
+  INT value = Value(lit);
+  if (value == 1) {
+    _conflict.assign({implied_by ^ 1, lit ^ 1});
+    return false;
+  }
+  if (!value) Enqueue(lit ^ 1, NONE, implied_by);
+  return true;
+}
+
+template <UINT H, UINT W, UINT N>
+bool CdclSolver<H,W,N>::Propagate() {
+  // Returns false, with the clause left in _conflict, on a conflict
+  while (_queue < _trail.size()) {
+    UINT lit = _trail[_queue++];
+    if (!(lit & 1)) {
+      // A cell took a value: no other values there, nor in affected cells
+      UINT var = lit >> 1, cell = var / G, val = var % G;
+      for (UINT other = 0; other < G; ++other) {
+        if (other != val && !Falsify((cell * G + other) << 1, lit)) return false;
+      }
+      for (UINT peer : _AT(_peers, cell)) {
+        if (!Falsify((peer * G + val) << 1, lit)) return false;
+      }
+    }
+    
+    // Visit the clauses watching the literal just made false
+    UINT false_lit = lit ^ 1;
+    std::vector<UINT>& watches = _watches[false_lit];
+    UINT keep = 0, next = 0;
+    while (next < watches.size()) {
+      UINT ci = watches[next++];
+      UINT* lits = &_lits[_clauses[ci].start];
+      if (lits[0] == false_lit) std::swap(lits[0], lits[1]);
+      if (Value(lits[0]) == 1) {
+        watches[keep++] = ci;
+        continue;
+      }
+      // Look for a replacement watch that is not false
+      bool moved = false;
+      for (UINT k = 2; k < _clauses[ci].size && !moved; ++k) {
+        if (Value(lits[k]) != -1) {
+          std::swap(lits[1], lits[k]);
+          _watches[lits[1]].push_back(ci);
+          moved = true;
+        }
+      }
+      if (moved) continue;
+      watches[keep++] = ci;
+      if (Value(lits[0]) == -1) {
+        _conflict.assign(lits, lits + _clauses[ci].size);
+        while (next < watches.size()) watches[keep++] = watches[next++];
+        watches.resize(keep);
+        return false;
+      }
+      Enqueue(lits[0], ci, NONE);
+    }
+    watches.resize(keep);
+  }
+  return true;
+}
+
+template <UINT H, UINT W, UINT N>
+void CdclSolver<H,W,N>::Analyse(UINT& level) {
+  // First unique implication point. The learnt clause holds the negation of
+  // that literal first, then false literals from earlier levels.
+  _learnt.assign(1, NONE);
+  std::vector<UINT> reason(_conflict);
+  UINT counter = 0, p = NONE, index = _trail.size();
+  while (true) {
+    for (UINT q : reason) {
+      if (q == p) continue;
+      UINT v = q >> 1;
+      if (_seen[v] || _vars[v].level == 0) continue;
+      _seen[v] = true;
+      BumpVariable(v);
+      if (_vars[v].level == Level()) ++counter;
+      else _learnt.push_back(q);
+    }
+    do { p = _trail[--index]; } while (!_seen[p >> 1]);
+    _seen[p >> 1] = false;
+    if (--counter == 0) break;
+    
+    UINT clause = _vars[p >> 1].clause;
+    if (clause != NONE && _clauses[clause].learnt) {
+      if ((_clauses[clause].activity += _clause_inc) > 1e20) {
+        for (Clause& c : _clauses) c.activity *= 1e-20;
+        _clause_inc *= 1e-20;
+      }
+    }
+    Reason(p >> 1, reason);
+  }
+  _learnt[0] = p ^ 1;
+  
+  // Drop literals whose reason is made up of literals already in the clause
+  _analysed.assign(_learnt.begin() + 1, _learnt.end());
+  UINT keep = 1;
+  for (UINT i = 1; i < _learnt.size(); ++i) {
+    UINT v = _learnt[i] >> 1;
+    bool redundant = _vars[v].clause != NONE || _vars[v].implied_by != NONE;
+    if (redundant) {
+      Reason(v, reason);
+      for (UINT q : reason) {
+        UINT u = q >> 1;
+        if (u != v && !_seen[u] && _vars[u].level > 0) {
+          redundant = false;
+          break;
+        }
+      }
+    }
+    if (!redundant) _learnt[keep++] = _learnt[i];
+  }
+  _learnt.resize(keep);
+  for (UINT lit : _analysed) _seen[lit >> 1] = false;
+  
+  // Backjump to the deepest level among the rest, watched second
+  level = 0;
+  UINT at = 1;
+  for (UINT i = 1; i < _learnt.size(); ++i) {
+    UINT v = _learnt[i] >> 1;
+    if (_vars[v].level > level) {
+      level = _vars[v].level;
+      at = i;
+    }
+  }
+  if (_learnt.size() > 1) std::swap(_learnt[1], _learnt[at]);
+}
+
+template <UINT H, UINT W, UINT N>
+void CdclSolver<H,W,N>::Reason(UINT var, std::vector<UINT>& lits) const {
+  const Assignment& a = _vars[var];
+  if (a.clause != NONE) {
+    const Clause& c = _clauses[a.clause];
+    lits.assign(&_lits[c.start], &_lits[c.start] + c.size);
+  } else {
+    UINT lit = (var << 1) | (_values[var] == -1 ? 1 : 0);
+    lits.assign({lit, a.implied_by ^ 1});
+  }
+}
+
+template <UINT H, UINT W, UINT N>
+void CdclSolver<H,W,N>::Backtrack(UINT level) {
+  if (Level() > level) {
+    UINT stop = _levels[level];
+    while (_trail.size() > stop) {
+      UINT v = _trail.back() >> 1;
+      _values[v] = 0;
+      if (!_heap.Contains(v)) _heap.Insert(v);
+      _trail.pop_back();
+    }
+    _levels.resize(level);
+  }
+  _queue = std::min(_queue, (UINT)_trail.size());
+}
+
+template <UINT H, UINT W, UINT N>
+UINT CdclSolver<H,W,N>::AddClause(const std::vector<UINT>& lits, bool learnt) {
+  UINT ci = _clauses.size();
+  _clauses.push_back(Clause{(UINT)_lits.size(), (UINT)lits.size(), learnt, 0});
+  _lits.insert(_lits.end(), lits.begin(), lits.end());
+  _watches[lits[0]].push_back(ci);
+  _watches[lits[1]].push_back(ci);
+  if (learnt) {
+    _clauses.back().activity = _clause_inc;
+    ++_learnts;
+  }
+  return ci;
+}
+
+template <UINT H, UINT W, UINT N>
+bool CdclSolver<H,W,N>::Locked(UINT ci) const {
+  UINT var = _lits[_clauses[ci].start] >> 1;
+  return _values[var] && _vars[var].clause == ci;
+}
+
+template <UINT H, UINT W, UINT N>
+void CdclSolver<H,W,N>::ReduceLearnt() {
+  // Drop the less active half of the longer learnt clauses that are not a
+  // reason right now, then compact the clause store and rebuild watches
+  std::vector<UINT> order;
+  for (UINT ci = 0; ci < _clauses.size(); ++ci) {
+    if (_clauses[ci].learnt && _clauses[ci].size > 2 && !Locked(ci))
+      order.push_back(ci);
+  }
+  std::sort(order.begin(), order.end(), [this](UINT a, UINT b) {
+    return _clauses[a].activity < _clauses[b].activity;
+  });
+  std::vector<bool> remove(_clauses.size(), false);
+  for (UINT i = 0; i < order.size() / 2; ++i) remove[order[i]] = true;
+  
+  std::vector<UINT> moved(_clauses.size(), NONE), lits;
+  std::vector<Clause> clauses;
+  lits.reserve(_lits.size());
+  _learnts = 0;
+  for (UINT ci = 0; ci < _clauses.size(); ++ci) {
+    if (remove[ci]) continue;
+    Clause c = _clauses[ci];
+    moved[ci] = clauses.size();
+    lits.insert(lits.end(), &_lits[c.start], &_lits[c.start] + c.size);
+    c.start = lits.size() - c.size;
+    clauses.push_back(c);
+    if (c.learnt) ++_learnts;
+  }
+  _clauses.swap(clauses);
+  _lits.swap(lits);
+  for (UINT lit : _trail) {
+    Assignment& a = _vars[lit >> 1];
+    if (a.clause != NONE) a.clause = moved[a.clause];
+  }
+  for (std::vector<UINT>& watches : _watches) watches.clear();
+  for (UINT ci = 0; ci < _clauses.size(); ++ci) {
+    _watches[_lits[_clauses[ci].start]].push_back(ci);
+    _watches[_lits[_clauses[ci].start + 1]].push_back(ci);
+  }
+  _max_learnts += _max_learnts / 10;
+}
+
+template <UINT H, UINT W, UINT N>
+bool CdclSolver<H,W,N>::BlockSolution() {
+  // Rule out the solution just found and carry on from the top. False if
+  // there is nothing left to rule out, as every cell was forced.
+  std::vector<UINT> clause;
+  for (UINT lit : _trail) {
+    if (!(lit & 1) && _vars[lit >> 1].level > 0) clause.push_back(lit ^ 1);
+  }
+  Backtrack(0);
+  if (clause.empty()) return false;
+  if (clause.size() == 1) Enqueue(clause[0], NONE, NONE);
+  else AddClause(clause, false);
+  return true;
+}
+
+template <UINT H, UINT W, UINT N>
+void CdclSolver<H,W,N>::BumpVariable(UINT var) {
+  if ((_activity[var] += _var_inc) > 1e100) {
+    for (double& a : _activity) a *= 1e-100;
+    _var_inc *= 1e-100;
+  }
+  if (_heap.Contains(var)) _heap.Increased(var);
+}
+
+// explicit init
+#define GRID_SIZE(x,y,z)\
+template class CdclSolver<x,y,z>;
+
+#include "gridsizes.itm"
+#undef GRID_SIZE
@@ -0,0 +1,102 @@
+//
+//  cdcl_solver.hpp
+//  SuDoKuSolver
+//
+//  Copyright © 2018 Hermes Productions. All rights reserved.
+//
+
+#ifndef SUDOKUSOLVER_CDCL_SOLVER_HPP
+#define SUDOKUSOLVER_CDCL_SOLVER_HPP
+
+#include "defines.hpp"
+
+#include <vector>
+
+#include "solver.hpp"
+
+// Binary max heap of variables ordered by an activity held elsewhere
+class VarHeap {
+  const std::vector<double>& _activity;
+  std::vector<UINT> _heap, _index;
+
+public:
+  VarHeap(const std::vector<double>& activity) : _activity(activity) { }
+  void Reset(UINT);
+  inline bool Empty() const { return _heap.empty(); }
+  inline bool Contains(UINT v) const { return _index[v] != ~UINT(0); }
+  void Insert(UINT);
+  // Restore order after the activity of a variable went up
+  void Increased(UINT);
+  UINT Pop();
+
+private:
+  void Up(UINT);
+  void Down(UINT);
+};
+
+// Conflict driven clause learning search. Each (cell, value) pair is a
+// variable. A true variable rules out the other values of its cell and the
+// same value in every affected cell directly, while the rule that every cell
+// and every (group, value) pair needs at least one true variable is kept as
+// clauses with two watched literals. Conflicts are learnt as new clauses,
+// the search backjumps non-chronologically, branches on the most active
+// variable and restarts on a Luby schedule.
+template <UINT H, UINT W = H, UINT N = H * H * W * W>
+class CdclSolver : public ISudokuSolver<H,W,N> {
+  static const UINT G = H * W;
+public:
+  typedef BITSET(G) Values;
+  typedef BITSET(N) AllCells;
+  typedef std::array<Values, N> GridState;
+
+public:
+  CdclSolver(SudokuGrid<H,W,N>&);
+  virtual bool Solve();
+  // Unsolved cells plus 100 per decision level the solution was found at
+  inline UINT GetScore() { return _score; }
+  inline UINT GetConflicts() { return _conflicts; }
+  inline UINT GetDecisions() { return _decisions; }
+
+private:
+  static const UINT NONE = ~UINT(0);
+  // Literals are variable * 2, plus one when negated
+  struct Clause { UINT start, size; bool learnt; double activity; };
+  // Implied either by a clause or by a single true literal
+  struct Assignment { UINT level, clause, implied_by; };
+
+  std::array<std::vector<UINT>, N> _peers;
+  std::vector<INT> _values;  // 1 true, -1 false, 0 unassigned
+  std::vector<Assignment> _vars;
+  std::vector<UINT> _trail, _levels;
+  UINT _queue;
+  std::vector<Clause> _clauses;
+  std::vector<UINT> _lits;
+  std::vector<std::vector<UINT>> _watches;
+  std::vector<double> _activity;
+  double _var_inc, _clause_inc;
+  VarHeap _heap;
+  std::vector<bool> _seen;
+  std::vector<UINT> _conflict, _learnt, _analysed;
+  UINT _max, _count, _score, _unsolved, _conflicts, _decisions;
+  UINT _learnts, _max_learnts;
+
+private:
+  bool Initialise();
+  inline UINT Level() const { return _levels.size(); }
+  inline INT Value(UINT lit) const {
+    return (lit & 1) ? -_values[lit >> 1] : _values[lit >> 1];
+  }
+  void Enqueue(UINT, UINT, UINT);
+  bool Falsify(UINT, UINT);
+  bool Propagate();
+  void Analyse(UINT&);
+  void Backtrack(UINT);
+  UINT AddClause(const std::vector<UINT>&, bool);
+  void Reason(UINT, std::vector<UINT>&) const;
+  bool Locked(UINT) const;
+  void ReduceLearnt();
+  bool BlockSolution();
+  void BumpVariable(UINT);
+};
+
+#endif /* SUDOKUSOLVER_CDCL_SOLVER_HPP */
@@ -0,0 +1,100 @@
+//
+//  columns.cpp
+//  SuDoKuSolver
+//
+//  Copyright © 2018 Hermes Productions. All rights reserved.
+//
+
+#include "columns.hpp"
+
+#include <algorithm>
+
+ColumnWriter::ColumnWriter(std::ostream& out, UINT rows_per_group)
+: _group(std::max(rows_per_group, (UINT)1)), _writer(out) { }
+
+UINT ColumnWriter::AddColumn(std::string_view name, UINT width) {
+  assert(!_started);
+  _columns.push_back({std::string(name.substr(0, 23)), width,
+                      std::vector<uint8_t>(_group * width)});
+  return _columns.size() - 1;
+}
+
+void ColumnWriter::Pad() {
+  static const char zeros[ALIGN] = {};
+  UINT written = (UINT)_writer.Written() % ALIGN;
+  if (written) _writer.Put(std::string_view(zeros, ALIGN - written));
+}
+
+void ColumnWriter::Start() {
+  _started = true;
+  uint32_t counts[2] = {LittleEndian((uint32_t)_columns.size()), LittleEndian((uint32_t)_group)};
+  _writer.Put("SDKCOLS1").Put(std::string_view((const char*)counts, sizeof(counts)));
+  for (const Column& c : _columns) {
+    char name[24] = {};
+    std::memcpy(name, c.name.data(), c.name.size());
+    uint32_t width[2] = {LittleEndian((uint32_t)c.width), 0};
+    _writer.Put(std::string_view(name, sizeof(name)))
+    .Put(std::string_view((const char*)width, sizeof(width)));
+  }
+  Pad();
+}
+
+void ColumnWriter::EndRow() {
+  if (!_started) Start();
+  if (++_rows == _group) WriteGroup();
+}
+
+void ColumnWriter::WriteGroup() {
+  uint64_t rows = LittleEndian((uint64_t)_rows);
+  _writer.Put(std::string_view((const char*)&rows, sizeof(rows)));
+  Pad();
+  for (Column& c : _columns) {
+    _writer.Put(std::string_view((const char*)c.block.data(), _rows * c.width));
+    Pad();
+  }
+  _writer.EndRecord();
+  _rows = 0;
+}
+
+void ColumnWriter::Close() {
+  if (_closed) return;
+  _closed = true;
+  if (!_started) Start();
+  if (_rows) WriteGroup();
+  _writer.Close();
+}
+
+namespace {
+  inline void Pack(const std::array<uint8_t, 81>& values, uint8_t* out) {
+    for (UINT i = 0; i < 81; i += 2)
+      out[i / 2] = (uint8_t)(values[i] | (i + 1 < 81 ? values[i + 1] << 4 : 0));
+  }
+}
+
+GradeColumns::GradeColumns(std::ostream& out)
+: _columns(out) {
+  _id = _columns.AddColumn("id", 8);
+  _clues = _columns.AddColumn("clues", 1);
+  _score = _columns.AddColumn("score", 4);
+  _hardest = _columns.AddColumn("hardest", 1);
+  // One column per technique, in LogicOperation order
+  _techniques = _columns.AddColumn(OperationName((LogicOperation)0), 2);
+  for (UINT op = 1; op < NUM_OPERATIONS; ++op)
+    _columns.AddColumn(OperationName((LogicOperation)op), 2);
+  _nanoseconds = _columns.AddColumn("nanoseconds", 8);
+  _puzzle = _columns.AddColumn("puzzle", 41);
+  _solution = _columns.AddColumn("solution", 41);
+}
+
+void GradeColumns::Write(const GradeRow& row) {
+  _columns.Put(_id, row.id);
+  _columns.Put(_clues, row.clues);
+  _columns.Put(_score, row.score);
+  _columns.Put(_hardest, (uint8_t)row.hardest);
+  for (UINT op = 0; op < NUM_OPERATIONS; ++op)
+    _columns.Put(_techniques + op, row.techniques[op]);
+  _columns.Put(_nanoseconds, row.nanoseconds);
+  Pack(row.puzzle, _columns.At(_puzzle));
+  Pack(row.solution, _columns.At(_solution));
+  _columns.EndRow();
+}
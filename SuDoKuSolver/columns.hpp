@@ -0,0 +1,110 @@
+//
+//  columns.hpp
+//  SuDoKuSolver
+//
+//  Copyright © 2018 Hermes Productions. All rights reserved.
+//
+
+#ifndef SUDOKUSOLVER_COLUMNS_HPP
+#define SUDOKUSOLVER_COLUMNS_HPP
+
+#include "defines.hpp"
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "operations.hpp"
+#include "writer.hpp"
+
+// An integer in the byte order the columns are stored in
+template <class T>
+inline T LittleEndian(T v) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  T r;
+  const uint8_t* in = (const uint8_t*)&v;
+  uint8_t* out = (uint8_t*)&r;
+  for (size_t i = 0; i < sizeof(T); ++i) out[i] = in[sizeof(T) - 1 - i];
+  return r;
+#else
+  return v;
+#endif
+}
+
+// Fixed width binary columns, written a row group at a time so they can be
+// memory mapped and scanned without parsing. Everything is little endian
+// and every block starts on a 64 byte boundary:
+//   header: "SDKCOLS1", uint32 columns, uint32 rows per group, then for
+//           each column a 24 byte name and uint32 width, uint32 zero
+//   groups: uint64 rows, then each column's rows * width bytes in turn
+// Groups are full apart from the last, and go to the stream through a
+// ResultWriter as they fill. With no rows there is only the header.
+class ColumnWriter {
+public:
+  static const UINT ALIGN = 64;
+
+  explicit ColumnWriter(std::ostream&, UINT rows_per_group = 4096);
+  ~ColumnWriter() { Close(); }
+
+  // Only before the first row
+  UINT AddColumn(std::string_view name, UINT width);
+  // Where the current row's value goes in a column
+  inline uint8_t* At(UINT column) {
+    Column& c = _AT(_columns, column);
+    return c.block.data() + _rows * c.width;
+  }
+  template <class T>
+  inline void Put(UINT column, T v) {
+    v = LittleEndian(v);
+    std::memcpy(At(column), &v, sizeof(T));
+  }
+  void EndRow();
+  // Writes the last group, which may be part full
+  void Close();
+
+private:
+  struct Column {
+    std::string name;
+    UINT width;
+    std::vector<uint8_t> block;
+  };
+
+  void Pad();
+  void Start();
+  void WriteGroup();
+
+  std::vector<Column> _columns;
+  UINT _group, _rows = 0;
+  bool _started = false, _closed = false;
+  ResultWriter _writer;
+};
+
+// One graded 9x9 puzzle: an id for the input record, and grids as values
+// with 0 for blanks
+struct GradeRow {
+  uint64_t id;
+  uint8_t clues;
+  uint32_t score;
+  LogicOperation hardest;
+  std::array<uint16_t, NUM_OPERATIONS> techniques;  // times each was used
+  uint64_t nanoseconds;
+  std::array<uint8_t, 81> puzzle, solution;
+};
+
+// The grading columns, with grids packed two cells to a byte
+class GradeColumns {
+public:
+  explicit GradeColumns(std::ostream&);
+  void Write(const GradeRow&);
+  void Close() { _columns.Close(); }
+
+private:
+  ColumnWriter _columns;
+  UINT _id, _clues, _score, _hardest, _techniques, _nanoseconds, _puzzle, _solution;
+};
+
+#endif /* SUDOKUSOLVER_COLUMNS_HPP */
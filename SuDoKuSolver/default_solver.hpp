@@ -0,0 +1,34 @@
+//
+//  default_solver.hpp
+//  SuDoKuSolver
+//
+//  Copyright © 2018 Hermes Productions. All rights reserved.
+//
+
+#ifndef SUDOKUSOLVER_DEFAULT_SOLVER_HPP
+#define SUDOKUSOLVER_DEFAULT_SOLVER_HPP
+
+#include "defines.hpp"
+
+#include "band_solver.hpp"
+#include "lane_solver.hpp"
+#include "solver.hpp"
+
+// Complete search used for a grid size when nothing asks for a particular
+// one. Sizes with a specialised engine pick it up here.
+template <UINT H, UINT W = H, UINT N = H * H * W * W>
+struct DefaultSolver {
+  typedef BruteForceSolver<H,W,N> type;
+};
+
+template <>
+struct DefaultSolver<3,3,81> {
+  typedef BandSolver type;
+};
+
+template <>
+struct DefaultSolver<4,4,256> {
+  typedef LaneSolver type;
+};
+
+#endif /* SUDOKUSOLVER_DEFAULT_SOLVER_HPP */
@@ -0,0 +1,124 @@
+//
+//  dispatch.cpp
+//  SuDoKuSolver
+//
+//  Copyright © 2018 Hermes Productions. All rights reserved.
+//
+
+#include "dispatch.hpp"
+
+#include "default_solver.hpp"
+#include "grid.hpp"
+#include "parser.hpp"
+
+const GridSize GRID_SIZES[NUM_GRID_SIZES] = {
+#define GRID_SIZE(x,y,z) {x, y, z},
+#include "gridsizes.itm"
+#undef GRID_SIZE
+};
+
+UINT DetectSize(std::string_view record, std::string_view& cells,
+                const PuzzleDialect& dialect) {
+  ParseResult counted;
+  return DetectSize(record, cells, counted, dialect);
+}
+
+UINT DetectSize(std::string_view record, std::string_view& cells, ParseResult& counted,
+                const PuzzleDialect& dialect) {
+  counted = {ParseError::NONE, 0, std::string_view()};
+  // A header leads the record, before any whitespace, metadata or cell
+  // other than its own digits, so colons in trailing metadata, such as
+  // "# 000::012::345", don't make one
+  size_t colon = std::string_view::npos;
+  for (size_t i = 0; i < record.size(); ++i) {
+    char c = record[i];
+    if (c == ':') {
+      colon = i;
+      break;
+    }
+    if ((c < '0' || c > '9') && c != 'x') break;
+  }
+  UINT h = 0, w = 0, pos = 0;
+  if (colon != std::string_view::npos) {
+    while (pos < colon && record[pos] >= '0' && record[pos] <= '9')
+      h = 10 * h + (record[pos++] - '0');
+    if (pos == colon || record[pos++] != 'x') return NUM_GRID_SIZES;
+    while (pos < colon && record[pos] >= '0' && record[pos] <= '9')
+      w = 10 * w + (record[pos++] - '0');
+    if (pos != colon) return NUM_GRID_SIZES;
+    record.remove_prefix(colon + 1);
+  }
+  UINT n;
+  counted = CountCells(record, dialect, n);
+  if (counted.error != ParseError::NONE) return NUM_GRID_SIZES;
+  cells = record.substr(0, counted.position);
+
+  // Without a header, every size has a different number of cells
+  for (UINT i = 0; i < NUM_GRID_SIZES; ++i) {
+    const GridSize& size = GRID_SIZES[i];
+    if (size.n != n) continue;
+    if (colon != std::string_view::npos && (size.h != h || size.w != w)) continue;
+    return i;
+  }
+  return NUM_GRID_SIZES;
+}
+
+namespace {
+  template <UINT H, UINT W, UINT N>
+  struct SizePool : public DispatchPool {
+    // Groups and cell positions for every grid of this size
+    SudokuGrid<H,W,N> layout;
+    SizePool() : layout(std::string(N, '.')) { }
+  };
+
+  template <UINT H, UINT W, UINT N>
+  bool SolveSize(std::unique_ptr<DispatchPool>& pool, std::string_view cells,
+                 DispatchResult& out, const SolveLimits& limits,
+                 const PuzzleDialect& dialect) {
+    if (!pool) pool.reset(new SizePool<H,W,N>());
+    const SizePool<H,W,N>& sized = static_cast<const SizePool<H,W,N>&>(*pool);
+    ParseResult parsed;
+    SudokuGrid<H,W,N> grid(cells, dialect, parsed, sized.layout);
+    out.parsed = parsed;
+    // Wrong characters or values out of range for the size. Conflicting
+    // clues are left for the solver to find unsolvable.
+    if (parsed.error != ParseError::NONE && parsed.error != ParseError::CONFLICT)
+      return false;
+    typename DefaultSolver<H,W,N>::type solver(grid);
+    solver.SetLimits(limits);
+    bool unique = solver.Solve();
+    out.result = solver.GetResult();
+    out.score = solver.GetScore();
+    out.solution.clear();
+    if (unique) {
+      const typename SudokuGrid<H,W,N>::GridState& solved = solver.GetSolvedState();
+      out.solution.resize(N);
+      for (UINT i = 0; i < N; ++i)
+        out.solution[i] = VALUE_CHARS[__find_first(_AT(solved, i))];
+    }
+    return true;
+  }
+
+  typedef bool (*SolveFn)(std::unique_ptr<DispatchPool>&, std::string_view,
+                          DispatchResult&, const SolveLimits&, const PuzzleDialect&);
+  const SolveFn SOLVE_SIZE[NUM_GRID_SIZES] = {
+#define GRID_SIZE(x,y,z) &SolveSize<x,y,z>,
+#include "gridsizes.itm"
+#undef GRID_SIZE
+  };
+}
+
+bool SizeDispatcher::Solve(std::string_view record, DispatchResult& out,
+                           const SolveLimits& limits, const PuzzleDialect& dialect) {
+  std::string_view cells;
+  UINT size = DetectSize(record, cells, dialect);
+  if (size == NUM_GRID_SIZES) return false;
+  return Solve(size, cells, out, limits, dialect);
+}
+
+bool SizeDispatcher::Solve(UINT size, std::string_view cells, DispatchResult& out,
+                           const SolveLimits& limits, const PuzzleDialect& dialect) {
+  if (size >= NUM_GRID_SIZES) return false;
+  out.size = size;
+  return SOLVE_SIZE[size](_pools[size], cells, out, limits, dialect);
+}
@@ -0,0 +1,78 @@
+//
+//  dispatch.hpp
+//  SuDoKuSolver
+//
+//  Copyright © 2018 Hermes Productions. All rights reserved.
+//
+
+#ifndef SUDOKUSOLVER_DISPATCH_HPP
+#define SUDOKUSOLVER_DISPATCH_HPP
+
+#include "defines.hpp"
+
+#include <array>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "parser.hpp"
+#include "solver.hpp"
+
+// The sizes in gridsizes.itm, in the same order
+struct GridSize { UINT h, w, n; };
+
+const UINT NUM_GRID_SIZES = 0
+#define GRID_SIZE(x,y,z) + 1
+#include "gridsizes.itm"
+#undef GRID_SIZE
+;
+
+extern const GridSize GRID_SIZES[NUM_GRID_SIZES];
+
+// Which size a record is, from an "HxW:" header when it has one and its
+// number of cells otherwise. Returns NUM_GRID_SIZES when no size fits, else
+// the index into GRID_SIZES with the part of the record holding the cells,
+// still in its dialect, in cells. Nothing is copied, so the cells are
+// parsed once, by whatever solves them.
+UINT DetectSize(std::string_view record, std::string_view& cells,
+                const PuzzleDialect& = PuzzleDialect::Default());
+// As above, with why the cells couldn't be counted, such as a bad
+// character, in counted
+UINT DetectSize(std::string_view record, std::string_view& cells, ParseResult& counted,
+                const PuzzleDialect& = PuzzleDialect::Default());
+
+// A puzzle of any size, solved by its size's default engine
+struct DispatchResult {
+  UINT size;              // index into GRID_SIZES
+  ParseResult parsed;     // why the cells couldn't be read, or CONFLICT
+  SolveResult result;
+  UINT score;
+  std::string solution;   // as a puzzle string, when solved. Reused, so
+                          // solving into the same result doesn't allocate.
+};
+
+// Per size state kept between puzzles, such as the group layout
+struct DispatchPool {
+  virtual ~DispatchPool() { }
+};
+
+// Front end for streams mixing grid sizes. Each record's size is found at
+// run time and the record is handed through a table to the instantiation
+// for it. Sizes are set up the first time they are seen and then reused,
+// so keep one per worker thread.
+class SizeDispatcher {
+public:
+  // False if the record isn't a puzzle of a known size. Limits reach every
+  // size's engine, giving an UNKNOWN result when they run out.
+  bool Solve(std::string_view record, DispatchResult&,
+             const SolveLimits& = SolveLimits(),
+             const PuzzleDialect& = PuzzleDialect::Default());
+  bool Solve(UINT size, std::string_view cells, DispatchResult&,
+             const SolveLimits& = SolveLimits(),
+             const PuzzleDialect& = PuzzleDialect::Default());
+
+private:
+  std::array<std::unique_ptr<DispatchPool>, NUM_GRID_SIZES> _pools;
+};
+
+#endif /* SUDOKUSOLVER_DISPATCH_HPP */
@@ -0,0 +1,216 @@
+//
+//  dlx_solver.cpp
+//  SuDoKuSolver
+//
+//  Copyright © 2018 Hermes Productions. All rights reserved.
+//
+
+#include "defines.hpp"
+#include <vector>
+
+#include "dlx_solver.hpp"
+#include "grid.hpp"
+#include "utility.hpp"
+
+template <UINT H, UINT W, UINT N>
+const UINT DancingLinksSolver<H,W,N>::NONE;
+
+template <UINT H, UINT W, UINT N>
+DancingLinksSolver<H,W,N>::DancingLinksSolver(SudokuGrid<H,W,N>& grid)
+: ISudokuSolver<H,W,N>(grid), _max(2), _count(0), _score(0), _nodes(0),
+_unsolved(0) { }
+
+template <UINT H, UINT W, UINT N>
+bool DancingLinksSolver<H,W,N>::Solve() {
+  Build();
+  _count = 0;
+  _score = _unsolved;
+  _nodes = 0;
+  
+  // Chosen row node at each level of the search
+  std::vector<UINT> chosen;
+  UINT guesses = 0;
+  bool forward = true;
+  while (true) {
+    if (forward) {
+      if (_links[0].right == 0) {
+        // Every column covered, so the chosen rows are a solution
+        ++_count;
+        this->_solved = this->_initial;
+        for (UINT node : chosen) {
+          const std::pair<UINT, UINT>& row = _AT(_rows, _links[node].row);
+          _AT(this->_solved, row.first).reset();
+          _AT(this->_solved, row.first).set(row.second);
+        }
+        _score += 100 * guesses;
+        if (_count == _max) break;  // bail out
+        forward = false;
+      } else {
+        UINT column = SmallestColumn();
+        if (_AT(_sizes, column) == 0) {
+          forward = false;
+        } else {
+          ++_nodes;
+          Cover(column);
+          if (_AT(_sizes, column) > 1) ++guesses;
+          UINT node = _links[column].down;
+          chosen.push_back(node);
+          for (UINT j = _links[node].right; j != node; j = _links[j].right)
+            Cover(_links[j].column);
+        }
+      }
+      continue;
+    }
+    
+    // Backtrack to the deepest level with another row left to try
+    if (chosen.empty()) break;
+    UINT node = chosen.back();
+    UINT column = _links[node].column;
+    for (UINT j = _links[node].left; j != node; j = _links[j].left)
+      Uncover(_links[j].column);
+    node = _links[node].down;
+    if (node == column) {
+      if (_AT(_sizes, column) > 1) --guesses;
+      Uncover(column);
+      chosen.pop_back();
+      continue;
+    }
+    chosen.back() = node;
+    for (UINT j = _links[node].right; j != node; j = _links[j].right)
+      Cover(_links[j].column);
+    forward = true;
+  }
+  return this->Finish(_count == 1);
+}
+
+template <UINT H, UINT W, UINT N>
+void DancingLinksSolver<H,W,N>::Build() {
+  const std::vector<AllCells>& groups = this->_groups;
+  _links.clear();
+  _sizes.clear();
+  _rows.clear();
+  _unsolved = 0;
+  
+  // Groups of each cell, only counting full groups that need every value
+  std::vector<std::vector<UINT>> cell_groups(N);
+  for (UINT g = 0; g < groups.size(); ++g) {
+    if (_AT(groups, g).count() != G) continue;
+    FORBITSIN(idx, _AT(groups, g)) _AT(cell_groups, idx).push_back(g);
+  }
+  
+  // Size the arena up front so it is never reallocated
+  UINT total = 1 + N + groups.size() * G;
+  for (UINT i = 0; i < N; ++i) {
+    if (this->_grid.GetCell(i).IsFixed()) continue;
+    total += _AT(this->_initial, i).count() * (1 + _AT(cell_groups, i).size());
+  }
+  _links.reserve(total);
+  _links.push_back({0, 0, 0, 0, 0, NONE});
+  _sizes.push_back(0);
+  
+  // Columns for unsolved cells and values not yet placed in each group
+  std::vector<UINT> cell_column(N, NONE), place_column(groups.size() * G, NONE);
+  for (UINT i = 0; i < N; ++i) {
+    if (this->_grid.GetCell(i).IsFixed()) continue;
+    _AT(cell_column, i) = AddColumn();
+    ++_unsolved;
+  }
+  for (UINT g = 0; g < groups.size(); ++g) {
+    if (_AT(groups, g).count() != G) continue;
+    Values placed(0);
+    FORBITSIN(idx, _AT(groups, g)) {
+      if (this->_grid.GetCell(idx).IsFixed()) placed |= _AT(this->_initial, idx);
+    }
+    for (UINT val = 0; val < G; ++val) {
+      if (!placed[val]) _AT(place_column, g * G + val) = AddColumn();
+    }
+  }
+  
+  // A row for each candidate, unless a clue already placed it in a group
+  std::vector<UINT> columns;
+  for (UINT i = 0; i < N; ++i) {
+    if (_AT(cell_column, i) == NONE) continue;
+    FORBITSIN(val, _AT(this->_initial, i)) {
+      columns.assign(1, _AT(cell_column, i));
+      for (UINT g : _AT(cell_groups, i)) {
+        UINT column = _AT(place_column, g * G + val);
+        if (column == NONE) break;
+        columns.push_back(column);
+      }
+      if (columns.size() == _AT(cell_groups, i).size() + 1)
+        AddRow(i, val, columns);
+    }
+  }
+}
+
+template <UINT H, UINT W, UINT N>
+UINT DancingLinksSolver<H,W,N>::AddColumn() {
+  UINT column = _links.size();
+  UINT last = _links[0].left;
+  _links.push_back({last, 0, column, column, column, NONE});
+  _links[last].right = column;
+  _links[0].left = column;
+  _sizes.push_back(0);
+  return column;
+}
+
+template <UINT H, UINT W, UINT N>
+void DancingLinksSolver<H,W,N>::AddRow(UINT cell, UINT val,
+                                       const std::vector<UINT>& columns) {
+  UINT row = _rows.size(), first = _links.size();
+  _rows.emplace_back(cell, val);
+  for (UINT column : columns) {
+    UINT node = _links.size(), above = _links[column].up;
+    _links.push_back({node == first ? node : node - 1, first, above, column,
+                      column, row});
+    _links[above].down = node;
+    _links[column].up = node;
+    if (node != first) {
+      _links[node - 1].right = node;
+      _links[first].left = node;
+    }
+    ++_AT(_sizes, column);
+  }
+}
+
+template <UINT H, UINT W, UINT N>
+void DancingLinksSolver<H,W,N>::Cover(UINT column) {
+  _links[_links[column].right].left = _links[column].left;
+  _links[_links[column].left].right = _links[column].right;
+  for (UINT i = _links[column].down; i != column; i = _links[i].down) {
+    for (UINT j = _links[i].right; j != i; j = _links[j].right) {
+      _links[_links[j].down].up = _links[j].up;
+      _links[_links[j].up].down = _links[j].down;
+      --_AT(_sizes, _links[j].column);
+    }
+  }
+}
+
+template <UINT H, UINT W, UINT N>
+void DancingLinksSolver<H,W,N>::Uncover(UINT column) {
+  for (UINT i = _links[column].up; i != column; i = _links[i].up) {
+    for (UINT j = _links[i].left; j != i; j = _links[j].left) {
+      ++_AT(_sizes, _links[j].column);
+      _links[_links[j].down].up = j;
+      _links[_links[j].up].down = j;
+    }
+  }
+  _links[_links[column].right].left = column;
+  _links[_links[column].left].right = column;
+}
+
+template <UINT H, UINT W, UINT N>
+UINT DancingLinksSolver<H,W,N>::SmallestColumn() const {
+  UINT best = _links[0].right;
+  for (UINT c = best; c != 0 && _AT(_sizes, best) > 1; c = _links[c].right) {
+    if (_AT(_sizes, c) < _AT(_sizes, best)) best = c;
+  }
+  return best;
+}
+
+// explicit init
+#define GRID_SIZE(x,y,z)\
+template class DancingLinksSolver<x,y,z>;
+
+#include "gridsizes.itm"
+#undef GRID_SIZE
@@ -0,0 +1,56 @@
+//
+//  dlx_solver.hpp
+//  SuDoKuSolver
+//
+//  Copyright © 2018 Hermes Productions. All rights reserved.
+//
+
+#ifndef SUDOKUSOLVER_DLX_SOLVER_HPP
+#define SUDOKUSOLVER_DLX_SOLVER_HPP
+
+#include "defines.hpp"
+
+#include <vector>
+
+#include "solver.hpp"
+
+// Algorithm X over Dancing Links. Each cell and each (group, value) pair is
+// a column that must be covered exactly once, and each candidate value of an
+// unsolved cell is a row. Columns come from the grid's groups, so layouts
+// other than rows, columns and blocks work unchanged.
+template <UINT H, UINT W = H, UINT N = H * H * W * W>
+class DancingLinksSolver : public ISudokuSolver<H,W,N> {
+  static const UINT G = H * W;
+public:
+  typedef BITSET(G) Values;
+  typedef BITSET(N) AllCells;
+  typedef std::array<Values, N> GridState;
+  
+public:
+  DancingLinksSolver(SudokuGrid<H,W,N>&);
+  virtual bool Solve();
+  inline UINT GetScore() { return _score; }
+  inline UINT GetNodes() { return _nodes; }
+  
+private:
+  // Links are indices into one contiguous arena. Node 0 is the root, the
+  // column headers follow it and then the rows' nodes.
+  struct Node { UINT left, right, up, down, column, row; };
+  static const UINT NONE = ~UINT(0);
+  
+  std::vector<Node> _links;
+  std::vector<UINT> _sizes;
+  // Cell and value of each row
+  std::vector<std::pair<UINT, UINT>> _rows;
+  UINT _max, _count, _score, _nodes, _unsolved;
+  
+private:
+  void Build();
+  UINT AddColumn();
+  void AddRow(UINT, UINT, const std::vector<UINT>&);
+  void Cover(UINT);
+  void Uncover(UINT);
+  UINT SmallestColumn() const;
+};
+
+#endif /* SUDOKUSOLVER_DLX_SOLVER_HPP */
@@ -11,8 +11,8 @@
 #include <stdexcept>
 #include <string>
 
+#include "default_solver.hpp"
 #include "grid.hpp"
-#include "solver.hpp"
 
 // Default constructor creates all cells, then calls SetGroups and SetAffected
 // Any classes inheriting should call this constructor in initalisation list
@@ -29,23 +29,69 @@ SudokuGrid<H,W,N>::SudokuGrid() {
 template<UINT H, UINT W, UINT N>
 SudokuGrid<H,W,N>::SudokuGrid(const std::string& s)
 : SudokuGrid() {
+  ParseResult result = Read(s, PuzzleDialect::Default());
+  switch (result.error) {
+    case ParseError::TOO_SHORT:
+    case ParseError::TOO_LONG:
+      throw std::length_error("Input string is incorrect length.");
+    case ParseError::BAD_CHARACTER:
+      throw std::runtime_error("Unknown characters in input string.");
+    case ParseError::VALUE_TOO_LARGE:
+      throw std::out_of_range("Characters in input have value greater than maximum.");
+    default:
+      break;
+  }
+}
+
+template<UINT H, UINT W, UINT N>
+SudokuGrid<H,W,N>::SudokuGrid(std::string_view s, const PuzzleDialect& dialect,
+                              ParseResult& result)
+: SudokuGrid() {
+  result = Read(s, dialect);
+}
+
+template<UINT H, UINT W, UINT N>
+SudokuGrid<H,W,N>::SudokuGrid(std::string_view s, const PuzzleDialect& dialect,
+                              ParseResult& result, const SudokuGrid& layout)
+: _grps(layout._grps), _affected(layout._affected) {
+  for (UINT i = 0; i < N; ++i) {
+    const Cell& from = layout.GetCell(i);
+    Cell& cell = _AT(_cells, i) = Cell(i);
+    cell.SetRow(from.GetRow());
+    cell.SetColumn(from.GetColumn());
+    cell.SetBlock(from.GetBlock());
+  }
+  result = Read(s, dialect);
+}
+
+// Candidates are worked out a group at a time: the clues in a group are
+// gathered, then taken from its other cells, rather than each clue being
+// taken from every cell it affects
+template<UINT H, UINT W, UINT N>
+ParseResult SudokuGrid<H,W,N>::Read(std::string_view s, const PuzzleDialect& dialect) {
   static_assert(G <= 62, "String construction can only handle 62 values");
-  if (s.size() != N) throw std::length_error("Input string is incorrect length.");
+  std::array<uint8_t, N> values;
+  ParseResult result = ParseValues(s, dialect, N, G, values.data());
+  if (result.error != ParseError::NONE) return result;
   
-  for (INT i = 0; i < N; ++i) {
-    INT v = (INT)_AT(s, i);
-    if (v == '.') continue;
-    else if (v >= '1' && v <= '9') v -= 48;
-    else if (v == '0') v = 10;
-    else if (v >= 'A' && v <= 'Z') v -= 54;
-    else if (v >= 'a' && v <= 'z') v -= 60;
-    else throw std::runtime_error("Unknown characters in input string.");
-    if (v > G) throw std::out_of_range("Characters in input have value greater than maximum.");
-    // Set fixed value and propagate consequences
-    GetCell(i).SetFixedValue(v);
-    const AllCells& affect = GetAffected(i);
-    for (INT j = 0; j < N; ++j) {
-      if (affect[j]) GetCell(j).ResetOption(v);
+  for (UINT i = 0; i < N; ++i) {
+    Cell& cell = GetCell(i);
+    if (_AT(values, i)) cell.SetFixedValue(_AT(values, i));
+  }
+  for (const AllCells& group : _grps) {
+    Values clues(0);
+    FORBITSIN(i, group) {
+      UINT v = _AT(values, i);
+      if (!v) continue;
+      if (clues[v - 1] && result.error == ParseError::NONE) {
+        result.error = ParseError::CONFLICT;
+        result.position = (UINT)i;
+      }
+      clues.set(v - 1);
+    }
+    FORBITSIN(i, group) {
+      Cell& cell = GetCell(i);
+      if (!cell.IsFixed()) cell.SetPossibleValues(cell.GetPossibleValues() & ~clues);
     }
   }
   
@@ -54,6 +100,7 @@ SudokuGrid<H,W,N>::SudokuGrid(const std::string& s)
     c.SetCurrentAsInitial();
     _AT(_initial, c.GetIndex()) = c.GetPossibleValues();
   }
+  return result;
 }
 
 template<UINT H, UINT W, UINT N>
@@ -61,7 +108,7 @@ const typename SudokuGrid<H,W,N>::GridState& SudokuGrid<H,W,N>::GetSolvedState()
   // Set solved state
   if (_num_solutions < 0) {
     UINT count = 0;
-    BruteForceSolver<H,W,N> solver(*this);
+    typename DefaultSolver<H,W,N>::type solver(*this);
     if (solver.Solve()) {
      ++count;
       _solved = solver.GetSolvedState();
@@ -174,18 +221,13 @@ std::ostream& SudokuGrid<H,W,N>::DisplayGrid(std::ostream& s) const {
 
 template <UINT H, UINT W, UINT N>
 std::ostream& SudokuGrid<H,W,N>::DisplayGridString(std::ostream& s) const {
-  for (const Cell& cell : _cells) {
-    UINT v = cell.GetValue();
-    char o;
-    if (cell.NumOptions() == 0) o = '+';
-    else if (v == 0) o = '.';
-    else if (v >= 1 && v <= 9) o = '0' + v;
-    else if (v == 10) o = '0';
-    else if (v >= 11 && v <= 36) o = '6' + v;
-    else o = '<' + v;
-    s << o;
+  // '+' marks a cell left with no options
+  char line[N];
+  for (UINT i = 0; i < N; ++i) {
+    const Cell& cell = GetCell(i);
+    line[i] = cell.NumOptions() ? CellChar(cell.GetValue()) : '+';
   }
-  return s;
+  return s.write(line, N);
 }
 
 template <UINT H, UINT W, UINT N>
@@ -198,9 +240,75 @@ bool SudokuGrid<H,W,N>::SetState(const GridState & state) {
   
   // Set state now
   for (UINT i = 0; i < N; ++i) _AT(_cells, i).SetPossibleValues(_AT(state, i));
+  ClearEdits();
+  return true;
+}
+
+template <UINT H, UINT W, UINT N>
+bool SudokuGrid<H,W,N>::Place(UINT idx, UINT v) {
+  if (idx >= N || v < 1 || v > G) return false;
+  if (GetCell(idx).IsFixed() || _placed[idx]) return false;
+  const GridState& solved = GetSolvedState();
+  Placement placement{idx, v, (UINT)_trail.size(), 0, false};
+  placement.wrong = _num_solutions == 1 && !_AT(solved, idx)[v - 1];
+  
+  Cell& cell = GetCell(idx);
+  _trail.emplace_back(idx, cell.GetPossibleValues());
+  cell.SetValue(v);
+  // Only the touched cell's peers can change
+  FORBITSIN(peer, GetAffected(idx)) {
+    Cell& other = GetCell(peer);
+    if (other.IsFixed() || _placed[peer]) {
+      if (other.GetValue() == v) ++placement.clashes;
+    } else if (other.GetPossibleValues()[v - 1]) {
+      _trail.emplace_back(peer, other.GetPossibleValues());
+      other.ResetOption(v);
+    }
+  }
+  _placed.set(idx);
+  _clashes += placement.clashes;
+  _wrong += placement.wrong;
+  _placements.push_back(placement);
+  return true;
+}
+
+template <UINT H, UINT W, UINT N>
+bool SudokuGrid<H,W,N>::Clear(UINT idx) {
+  if (idx >= N || !_placed[idx]) return false;
+  UINT at = (UINT)_placements.size();
+  while (_AT(_placements, --at).idx != idx) { }
+  // Later placements may rest on this one's removals, so they are taken
+  // back with it and made again
+  std::vector<std::pair<UINT, UINT>> replay;
+  for (UINT i = at + 1; i < _placements.size(); ++i)
+    replay.emplace_back(_placements[i].idx, _placements[i].value);
+  for (UINT i = at; i < _placements.size(); ++i) {
+    _placed.reset(_placements[i].idx);
+    _clashes -= _placements[i].clashes;
+    _wrong -= _placements[i].wrong;
+  }
+  Unwind(_AT(_placements, at).trail);
+  _placements.resize(at);
+  for (auto& p : replay) Place(p.first, p.second);
   return true;
 }
 
+template <UINT H, UINT W, UINT N>
+void SudokuGrid<H,W,N>::Unwind(UINT trail) {
+  while (_trail.size() > trail) {
+    GetCell(_trail.back().first).SetPossibleValues(_trail.back().second);
+    _trail.pop_back();
+  }
+}
+
+template <UINT H, UINT W, UINT N>
+void SudokuGrid<H,W,N>::ClearEdits() {
+  _placements.clear();
+  _trail.clear();
+  _placed.reset();
+  _wrong = _clashes = 0;
+}
+
 template<UINT H, UINT W, UINT N>
 void SudokuGrid<H,W,N>::PrintSeperatorGridLine(std::ostream& s) const {
   for (INT i = 0; i < G; ++i) {
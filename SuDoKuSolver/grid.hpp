@@ -19,9 +19,11 @@
 #endif
 #include <cassert>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "cell.hpp"
+#include "parser.hpp"
 
 // Beginings of grid interface
 template <UINT H, UINT W = H, UINT N = H * H * W *W>
@@ -62,6 +64,12 @@ protected:
 public:
   
   SudokuGrid(const std::string&);
+  // Read any dialect without throwing. The grid is only usable when the
+  // result has no error, or a conflict.
+  SudokuGrid(std::string_view, const PuzzleDialect&, ParseResult&);
+  // As above, but taking groups and cell positions from another grid of
+  // the same size instead of working them out again
+  SudokuGrid(std::string_view, const PuzzleDialect&, ParseResult&, const SudokuGrid&);
   
   // Move constructor
 //  SudokuGrid(SudokuGrid&&);
@@ -94,12 +102,19 @@ public:
   // State stuff
   inline const GridState& GetInitialState() const { return _initial; }
   bool SetState(const GridState&);
-  void Reset() { for (Cell& c : _cells) c.Reset(); }
+  void Reset() { for (Cell& c : _cells) c.Reset(); ClearEdits(); }
   bool Solve();  // Set state to solved state
   bool LogicalSolve();
   bool CheckCurrentState() const;
   GridState GetCurrentState() const;
   const GridState& GetSolvedState();
+  // Take a solution found elsewhere, such as a batch solve, instead of
+  // searching for it again
+  inline void SetSolvedState(const GridState& solved, bool unique, UINT score) {
+    _solved = solved;
+    _num_solutions = unique ? 1 : 0;
+    _score = score;
+  }
   // Check if grid is in a valid state
   bool IsValid() const;
   // Check if grid can be solved
@@ -107,7 +122,31 @@ public:
   // Check if grid is solved
   bool IsSolved() const;
   
+  // Player edits, kept up to date from the touched cell alone. Place puts
+  // value v (1 to G) in a cell that isn't a clue, taking v from its peers.
+  // Clear takes a placement back by rolling the trail back to it, then
+  // placing again any made since.
+  bool Place(UINT idx, UINT v);
+  bool Clear(UINT idx);
+  // No placed value clashes with a peer's, without sweeping the groups
+  inline bool EditsValid() const { return _clashes == 0; }
+  // Every placement agrees with the unique solution, so the grid can still
+  // be completed. The solution is found once, on the first placement.
+  inline bool EditsSolvable() { return IsSolvable() && _wrong == 0; }
+  
 private:
+  // Placements in order, with the trail length before each
+  struct Placement { UINT idx, value, trail, clashes; bool wrong; };
+  std::vector<Placement> _placements;
+  // Cells changed by placements, with their candidates before
+  std::vector<std::pair<UINT, Values>> _trail;
+  AllCells _placed;
+  UINT _wrong = 0, _clashes = 0;
+  
+  void ClearEdits();
+  void Unwind(UINT trail);
+
+  ParseResult Read(std::string_view, const PuzzleDialect&);
   virtual void SetGroups();
   virtual void SetAffected();
   
@@ -0,0 +1,96 @@
+//
+//  histogram.cpp
+//  SuDoKuSolver
+//
+//  Copyright © 2018 Hermes Productions. All rights reserved.
+//
+
+#include "histogram.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <string>
+
+LatencyHistogram::LatencyHistogram() {
+  Reset();
+}
+
+void LatencyHistogram::Reset() {
+  _buckets.fill(0);
+  _count = _max = _total = 0;
+  _min = UINT64_MAX;
+}
+
+UINT LatencyHistogram::Bucket(uint64_t value) {
+  if (value < SUB) return (UINT)value;
+  UINT msb = 63 - __builtin_clzll(value);
+  UINT shift = msb - (SUB_BITS - 1);
+  return SUB + (shift - 1) * HALF + (UINT)(value >> shift) - HALF;
+}
+
+uint64_t LatencyHistogram::Highest(UINT bucket) {
+  if (bucket < SUB) return bucket;
+  UINT shift = (bucket - SUB) / HALF + 1;
+  uint64_t sub = (bucket - SUB) % HALF + HALF;
+  return ((sub + 1) << shift) - 1;
+}
+
+void LatencyHistogram::Record(uint64_t value) {
+  ++_AT(_buckets, Bucket(value));
+  ++_count;
+  _total += value;
+  if (value < _min) _min = value;
+  if (value > _max) _max = value;
+}
+
+LatencyHistogram& LatencyHistogram::operator+=(const LatencyHistogram& o) {
+  for (UINT i = 0; i < BUCKETS; ++i) _buckets[i] += o._buckets[i];
+  _count += o._count;
+  _total += o._total;
+  _min = std::min(_min, o._min);
+  _max = std::max(_max, o._max);
+  return *this;
+}
+
+uint64_t LatencyHistogram::Percentile(double fraction) const {
+  if (!_count) return 0;
+  uint64_t target = (uint64_t)std::ceil(fraction * _count);
+  if (target < 1) target = 1;
+  uint64_t seen = 0;
+  for (UINT i = 0; i < BUCKETS; ++i) {
+    seen += _buckets[i];
+    if (seen >= target) return std::min(Highest(i), _max);
+  }
+  return _max;
+}
+
+LatencyReport& LatencyReport::operator+=(const LatencyReport& o) {
+  for (auto& h : o._histograms) _histograms[h.first] += h.second;
+  return *this;
+}
+
+std::ostream& LatencyReport::Write(std::ostream& s) const {
+  auto line = [&s](const std::string& size, const char* op, const LatencyHistogram& h) {
+    s << std::setw(7) << size << " " << std::setw(22) << op
+    << std::setw(10) << h.GetCount();
+    for (double p : {0.5, 0.9, 0.99, 0.999})
+      s << std::setw(11) << h.Percentile(p) / 1000.0;
+    s << std::setw(11) << h.GetMax() / 1000.0 << "\n";
+  };
+  std::ios::fmtflags flags = s.flags();
+  s << std::fixed << std::setprecision(1);
+  s << std::setw(7) << "size" << " " << std::setw(22) << "hardest"
+  << std::setw(10) << "count" << std::setw(11) << "p50 us" << std::setw(11)
+  << "p90 us" << std::setw(11) << "p99 us" << std::setw(11) << "p999 us"
+  << std::setw(11) << "max us" << "\n";
+  LatencyHistogram all;
+  for (auto& h : _histograms) {
+    std::string size = std::to_string(h.first.first) + "x" + std::to_string(h.first.first);
+    line(size, OperationName(h.first.second), h.second);
+    all += h.second;
+  }
+  line("all", "all", all);
+  s.flags(flags);
+  return s << std::flush;
+}
@@ -0,0 +1,73 @@
+//
+//  histogram.hpp
+//  SuDoKuSolver
+//
+//  Copyright © 2018 Hermes Productions. All rights reserved.
+//
+
+#ifndef SUDOKUSOLVER_HISTOGRAM_HPP
+#define SUDOKUSOLVER_HISTOGRAM_HPP
+
+#include "defines.hpp"
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <utility>
+
+#include "operations.hpp"
+
+// Log bucketed latency histogram in the style of HdrHistogram. Values below
+// 2^SUB_BITS get a bucket each, above that every power of two is split into
+// 2^(SUB_BITS - 1) linear buckets, so any value is reported to within about
+// 3% using a fixed 15KB whatever the range recorded.
+class LatencyHistogram {
+  static const UINT SUB_BITS = 6;
+  static const UINT SUB = 1 << SUB_BITS;
+  static const UINT HALF = SUB / 2;
+  static const UINT BUCKETS = SUB + (64 - SUB_BITS) * HALF;
+public:
+  LatencyHistogram();
+  void Record(uint64_t);
+  void Reset();
+  LatencyHistogram& operator+=(const LatencyHistogram&);
+  // Smallest recorded bucket bound covering the given fraction of values
+  uint64_t Percentile(double) const;
+  inline uint64_t GetCount() const { return _count; }
+  inline uint64_t GetMin() const { return _count ? _min : 0; }
+  inline uint64_t GetMax() const { return _max; }
+  inline uint64_t GetTotal() const { return _total; }
+
+private:
+  std::array<uint64_t, BUCKETS> _buckets;
+  uint64_t _count, _min, _max, _total;
+
+private:
+  static UINT Bucket(uint64_t);
+  static uint64_t Highest(UINT);
+};
+
+// Solve times in nanoseconds keyed by grid size and the hardest logical
+// operation a solve needed. Keep one per thread and add them together.
+class LatencyReport {
+public:
+  typedef std::pair<UINT, LogicOperation> Key;
+
+public:
+  inline void Record(UINT size, LogicOperation op, uint64_t nanoseconds) {
+    _histograms[Key(size, op)].Record(nanoseconds);
+  }
+  inline void Reset() { _histograms.clear(); }
+  inline bool Empty() const { return _histograms.empty(); }
+  LatencyReport& operator+=(const LatencyReport&);
+  const std::map<Key, LatencyHistogram>& Histograms() const { return _histograms; }
+  // One line per key, and one for all of them, with count, p50, p90, p99,
+  // p999 and max in microseconds
+  std::ostream& Write(std::ostream&) const;
+
+private:
+  std::map<Key, LatencyHistogram> _histograms;
+};
+
+#endif /* SUDOKUSOLVER_HISTOGRAM_HPP */
@@ -0,0 +1,156 @@
+//
+//  instrument.hpp
+//  SuDoKuSolver
+//
+//  Copyright © 2018 Hermes Productions. All rights reserved.
+//
+
+#ifndef SUDOKUSOLVER_INSTRUMENT_HPP
+#define SUDOKUSOLVER_INSTRUMENT_HPP
+
+#include "defines.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+#include "operations.hpp"
+#include "perf_counters.hpp"
+
+// What one logical technique cost and achieved
+struct TechniqueStats {
+  uint64_t calls = 0;
+  uint64_t successes = 0;     // calls that found something to do
+  uint64_t eliminations = 0;  // candidates removed
+  uint64_t scanned = 0;       // groups, combinations or patterns looked at
+  uint64_t nanoseconds = 0;
+  PerfSample counters;        // when hardware counters are attached
+
+  TechniqueStats& operator+=(const TechniqueStats& o) {
+    calls += o.calls;
+    successes += o.successes;
+    eliminations += o.eliminations;
+    scanned += o.scanned;
+    nanoseconds += o.nanoseconds;
+    counters += o.counters;
+    return *this;
+  }
+};
+
+// Stats for every LogicOperation, and for applying what they find. Each
+// solver, or each thread, keeps its own set and they are added together
+// afterwards, so recording never needs a lock.
+class Instruments {
+  std::array<TechniqueStats, NUM_OPERATIONS> _stats;
+  TechniqueStats _actions;    // applying what the techniques found
+  const PerfCounters* _perf = nullptr;
+
+public:
+  // Also count hardware events per technique. The counters must belong to
+  // the thread doing the solving.
+  inline void SetPerfCounters(const PerfCounters* perf) { _perf = perf; }
+  inline const PerfCounters* GetPerfCounters() const { return _perf; }
+  inline TechniqueStats& Get(LogicOperation op) { return _AT(_stats, (UINT)op); }
+  inline const TechniqueStats& Get(LogicOperation op) const { return _AT(_stats, (UINT)op); }
+  inline TechniqueStats& Actions() { return _actions; }
+  inline const TechniqueStats& Actions() const { return _actions; }
+  void Reset() { _stats.fill(TechniqueStats()); _actions = TechniqueStats(); }
+  Instruments& operator+=(const Instruments& o) {
+    for (UINT i = 0; i < NUM_OPERATIONS; ++i) _stats[i] += o._stats[i];
+    _actions += o._actions;
+    return *this;
+  }
+
+  std::ostream& WriteJson(std::ostream& s) const {
+    s << "{\"techniques\": [";
+    for (UINT i = 0; i <= NUM_OPERATIONS; ++i) {
+      const TechniqueStats& t = i < NUM_OPERATIONS ? _stats[i] : _actions;
+      s << (i ? ",\n  " : "\n  ") << "{\"name\": \"" << Name(i) << "\", \"calls\": " << t.calls
+      << ", \"successes\": " << t.successes << ", \"eliminations\": "
+      << t.eliminations << ", \"scanned\": " << t.scanned
+      << ", \"nanoseconds\": " << t.nanoseconds;
+      for (UINT e = 0; e < NUM_PERF_EVENTS; ++e)
+        s << ", \"" << PerfEventName((PerfEvent)e) << "\": " << t.counters.values[e];
+      s << "}";
+    }
+    return s << "\n]}" << std::endl;
+  }
+  std::ostream& WriteCsv(std::ostream& s) const {
+    s << "technique,calls,successes,eliminations,scanned,nanoseconds";
+    for (UINT e = 0; e < NUM_PERF_EVENTS; ++e) s << "," << PerfEventName((PerfEvent)e);
+    s << "\n";
+    for (UINT i = 0; i <= NUM_OPERATIONS; ++i) {
+      const TechniqueStats& t = i < NUM_OPERATIONS ? _stats[i] : _actions;
+      s << Name(i) << "," << t.calls << ","
+      << t.successes << "," << t.eliminations << "," << t.scanned << ","
+      << t.nanoseconds;
+      for (UINT e = 0; e < NUM_PERF_EVENTS; ++e) s << "," << t.counters.values[e];
+      s << "\n";
+    }
+    return s << std::flush;
+  }
+
+private:
+  static const char* Name(UINT i) {
+    return i < NUM_OPERATIONS ? OperationName((LogicOperation)i) : "handle_actions";
+  }
+};
+
+// Records one call of a technique over its scope. Success and eliminations
+// are read from the solver's pending flag and removal count at the end.
+class TechniqueTimer {
+  typedef std::chrono::steady_clock Clock;
+  TechniqueStats& _stats;
+  const PerfCounters* _perf;
+  PerfSample _counters_start;
+  const bool& _pending;
+  const uint64_t& _removed;
+  uint64_t _removed_start;
+  Clock::time_point _start;
+
+public:
+  TechniqueTimer(TechniqueStats& stats, const PerfCounters* perf,
+                 const bool& pending, const uint64_t& removed)
+  : _stats(stats), _perf(perf), _pending(pending), _removed(removed),
+  _removed_start(removed) {
+    if (_perf) _perf->Read(_counters_start);
+    _start = Clock::now();
+  }
+  ~TechniqueTimer() {
+    _stats.nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>
+      (Clock::now() - _start).count();
+    if (_perf) {
+      PerfSample end;
+      _perf->Read(end);
+      _stats.counters += end - _counters_start;
+    }
+    ++_stats.calls;
+    if (_pending) ++_stats.successes;
+    _stats.eliminations += _removed - _removed_start;
+  }
+  inline void Scanned(uint64_t n) { _stats.scanned += n; }
+};
+
+// Recording only happens when built with USE_INSTRUMENTATION, otherwise
+// these expand to nothing
+#ifdef USE_INSTRUMENTATION
+#define INSTRUMENT_STATS(instruments,stats,pending,removed)\
+TechniqueTimer _technique_timer(stats, (instruments).GetPerfCounters(), pending, removed)
+#define INSTRUMENT_TECHNIQUE(instruments,op,pending,removed)\
+INSTRUMENT_STATS(instruments, (instruments).Get(op), pending, removed)
+#define INSTRUMENT_SCANNED(n)\
+_technique_timer.Scanned(n)
+#define INSTRUMENT_COUNT(counter)\
+++(counter)
+#define INSTRUMENT_ADD(counter,n)\
+(counter) += (n)
+#else
+#define INSTRUMENT_STATS(instruments,stats,pending,removed) ((void)(pending), (void)(removed))
+#define INSTRUMENT_TECHNIQUE(instruments,op,pending,removed) ((void)0)
+#define INSTRUMENT_SCANNED(n) ((void)0)
+#define INSTRUMENT_COUNT(counter) ((void)0)
+#define INSTRUMENT_ADD(counter,n) ((void)0)
+#endif
+
+#endif /* SUDOKUSOLVER_INSTRUMENT_HPP */
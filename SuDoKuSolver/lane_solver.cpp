@@ -0,0 +1,156 @@
+//
+//  lane_solver.cpp
+//  SuDoKuSolver
+//
+//  Copyright © 2018 Hermes Productions. All rights reserved.
+//
+#include "defines.hpp"
+
+#include "grid.hpp"
+#include "lane_solver.hpp"
+#include "lanes.hpp"
+
+using namespace lanes;
+
+namespace {
+  // Naked then hidden singles within one group. Lanes of broken are set
+  // when a value is solved twice, has nowhere to go or a cell runs out.
+  inline Lanes Group(Lanes cells, Lanes& broken) {
+    Lanes single = Single(cells), seen, once, twice;
+    Counts(single, seen, twice);
+    broken = Or(broken, twice);
+    cells = AndNot(cells, AndNot(seen, single));
+    Counts(cells, once, twice);
+    broken = Or(broken, AndNot(Fill(0xFFFF), once));
+    cells = Narrow(cells, And(cells, AndNot(once, twice)));
+    broken = Or(broken, IsZero(cells));
+    return cells;
+  }
+}
+
+LaneSolver::LaneSolver(SudokuGrid<4,4,256>& grid)
+: ISudokuSolver<4,4,256>(grid), _count(0), _score(0), _nodes(0), _stopped(false) { }
+
+bool LaneSolver::Solve() {
+  State state;
+  _count = _score = _nodes = 0;
+  _stopped = false;
+  for (UINT i = 0; i < N; ++i) {
+    state.cells[i] = (uint16_t)_AT(_initial, i).to_ulong();
+    if (!_grid.GetCell(i).IsFixed()) ++_score;
+  }
+  Search(state, 0);
+  _stats.nodes = _nodes;
+  if (_stopped) {
+    _result = SolveResult::UNKNOWN;
+    return false;
+  }
+  return Finish(_count == 1);
+}
+
+bool LaneSolver::Search(State& state, UINT guesses) {
+  // Returns true once enough solutions are found, or the limits run out,
+  // to stop
+  if (_limits.Exceeded(++_nodes)) {
+    _stopped = true;
+    return true;
+  }
+  State before = state;
+  if (!Propagate(state)) return false;
+
+  // Branch on the unsolved cell with the fewest candidates. Ties go to a
+  // cell this node's propagation narrowed, keeping the search near its
+  // last guess.
+  UINT cell = N, fewest = G + 1;
+  bool recent = false;
+  for (UINT i = 0; i < N; ++i) {
+    UINT count = __builtin_popcount(state.cells[i]);
+    if (count < 2 || count > fewest) continue;
+    bool narrowed = state.cells[i] != before.cells[i];
+    if (count < fewest || (narrowed && !recent)) {
+      cell = i;
+      fewest = count;
+      recent = narrowed;
+    }
+  }
+  if (cell == N) {
+    ++_count;
+    _score += 100 * guesses;
+    for (UINT i = 0; i < N; ++i) _AT(_solved, i) = Values(state.cells[i]);
+    return _count == 2;
+  }
+
+  // Without a pair of candidates, try a group value with two places left
+  if (fewest > 2) {
+    for (UINT g = 0; g < 3 * G; ++g) {
+      Lanes once, twice, more;
+      Counts(LoadGroup(state, g), once, twice, more);
+      uint16_t pairs = First(AndNot(twice, more));
+      if (!pairs) continue;
+      uint16_t value = pairs & -pairs;
+      for (UINT i = 0; i < G; ++i) {
+        UINT idx = GroupCell(g, i);
+        if (!(state.cells[idx] & value)) continue;
+        State next = state;
+        next.cells[idx] = value;
+        if (Search(next, guesses + 1)) return true;
+      }
+      return false;
+    }
+  }
+
+  for (UINT v = 0; v < G; ++v) {
+    if (!(state.cells[cell] >> v & 1)) continue;
+    State next = state;
+    next.cells[cell] = 1 << v;
+    if (Search(next, guesses + 1)) return true;
+  }
+  return false;
+}
+
+Lanes LaneSolver::LoadGroup(const State& state, UINT g) const {
+  if (g < G) return LoadLanes(state.cells + G * g);
+  if (g < 2 * G) return LoadLanes(_columns + G * (g - G));
+  g -= 2 * G;
+  return LoadRuns(state.cells + g / 4 * 4 * G + g % 4 * 4, G);
+}
+
+UINT LaneSolver::GroupCell(UINT g, UINT i) {
+  if (g < G) return G * g + i;
+  if (g < 2 * G) return G * i + g - G;
+  g -= 2 * G;
+  return (g / 4 * 4 + i / 4) * G + g % 4 * 4 + i % 4;
+}
+
+bool LaneSolver::Propagate(State& state) {
+  // Sweep rows, blocks and columns until nothing changes. Returns false on
+  // a contradiction.
+  while (true) {
+    Lanes diff = Zero(), broken = Zero();
+    for (UINT r = 0; r < G; ++r) {
+      Lanes cells = LoadLanes(state.cells + G * r);
+      Lanes next = Group(cells, broken);
+      diff = Or(diff, Xor(cells, next));
+      StoreLanes(state.cells + G * r, next);
+    }
+    for (UINT b = 0; b < G; ++b) {
+      uint16_t* first = state.cells + b / 4 * 4 * G + b % 4 * 4;
+      Lanes cells = LoadRuns(first, G);
+      Lanes next = Group(cells, broken);
+      diff = Or(diff, Xor(cells, next));
+      StoreRuns(first, G, next);
+    }
+    Transpose(state.cells, _columns);
+    Lanes column_diff = Zero();
+    for (UINT c = 0; c < G; ++c) {
+      Lanes cells = LoadLanes(_columns + G * c);
+      Lanes next = Group(cells, broken);
+      column_diff = Or(column_diff, Xor(cells, next));
+      StoreLanes(_columns + G * c, next);
+    }
+    if (Any(column_diff)) Transpose(_columns, state.cells);
+
+    if (Any(broken)) return false;
+    if (!Any(Or(diff, column_diff))) return true;
+  }
+}
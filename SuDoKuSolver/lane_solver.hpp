@@ -0,0 +1,50 @@
+//
+//  lane_solver.hpp
+//  SuDoKuSolver
+//
+//  Copyright © 2018 Hermes Productions. All rights reserved.
+//
+
+#ifndef SUDOKUSOLVER_LANE_SOLVER_HPP
+#define SUDOKUSOLVER_LANE_SOLVER_HPP
+
+#include "defines.hpp"
+
+#include <cstdint>
+
+#include "lanes.hpp"
+#include "solver.hpp"
+
+// Search specialised to regular 16x16 grids. A group's sixteen 16 bit
+// candidate masks fill one vector register: rows are stored in order,
+// blocks are loaded as four runs of four, and columns are worked on in a
+// transposed copy. Naked singles, value counts and hidden singles for a
+// group are then a handful of vector instructions each.
+class LaneSolver : public ISudokuSolver<4,4,256> {
+  static const UINT G = 16;
+  static const UINT N = 256;
+public:
+  LaneSolver(SudokuGrid<4,4,256>&);
+  virtual bool Solve();
+  // Unfixed cells plus 100 per guess on the path to each solution, as
+  // BruteForceSolver scores
+  inline UINT GetScore() { return _score; }
+  inline UINT GetNodes() { return _nodes; }
+
+private:
+  struct State { alignas(32) uint16_t cells[N]; };
+
+  UINT _count, _score, _nodes;
+  bool _stopped;  // limits ran out
+  alignas(32) uint16_t _columns[N];
+
+private:
+  bool Search(State&, UINT);
+  bool Propagate(State&);
+  // Rows, columns then blocks, as the grid orders them. Columns come from
+  // the transposed copy the last Propagate left.
+  lanes::Lanes LoadGroup(const State&, UINT) const;
+  static UINT GroupCell(UINT, UINT);
+};
+
+#endif /* SUDOKUSOLVER_LANE_SOLVER_HPP */
@@ -0,0 +1,192 @@
+//
+//  lanes.hpp
+//  SuDoKuSolver
+//
+//  Copyright © 2018 Hermes Productions. All rights reserved.
+//
+
+#ifndef SUDOKUSOLVER_LANES_HPP
+#define SUDOKUSOLVER_LANES_HPP
+
+#include "defines.hpp"
+
+#include <cstdint>
+#include <cstring>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+// Sixteen 16 bit candidate masks worked on together: one AVX2 register, or
+// a plain array looped over when AVX2 is not enabled. Memory passed to
+// LoadLanes and StoreLanes must be 32 byte aligned.
+namespace lanes {
+  const UINT COUNT = 16;
+
+#ifdef __AVX2__
+  typedef __m256i Lanes;
+
+  inline Lanes LoadLanes(const uint16_t* p) { return _mm256_load_si256((const __m256i*)p); }
+  inline void StoreLanes(uint16_t* p, Lanes a) { _mm256_store_si256((__m256i*)p, a); }
+  inline Lanes Zero() { return _mm256_setzero_si256(); }
+  inline Lanes Fill(uint16_t v) { return _mm256_set1_epi16(v); }
+  inline Lanes And(Lanes a, Lanes b) { return _mm256_and_si256(a, b); }
+  inline Lanes Or(Lanes a, Lanes b) { return _mm256_or_si256(a, b); }
+  inline Lanes Xor(Lanes a, Lanes b) { return _mm256_xor_si256(a, b); }
+  // a & ~b
+  inline Lanes AndNot(Lanes a, Lanes b) { return _mm256_andnot_si256(b, a); }
+  // All ones in lanes that are zero
+  inline Lanes IsZero(Lanes a) { return _mm256_cmpeq_epi16(a, Zero()); }
+  // The mask where it has exactly one value, else zero
+  inline Lanes Single(Lanes a) {
+    Lanes rest = And(a, _mm256_sub_epi16(a, Fill(1)));
+    return And(a, IsZero(rest));
+  }
+  // b where it is non-zero, else a
+  inline Lanes Narrow(Lanes a, Lanes b) { return _mm256_blendv_epi8(b, a, IsZero(b)); }
+  inline bool Any(Lanes a) { return !_mm256_testz_si256(a, a); }
+  inline uint16_t First(Lanes a) { return (uint16_t)_mm256_extract_epi16(a, 0); }
+
+  // Four runs of four masks, stride apart, such as a 4x4 block of a grid
+  inline Lanes LoadRuns(const uint16_t* p, UINT stride) {
+    int64_t runs[4];
+    for (UINT i = 0; i < 4; ++i) std::memcpy(&runs[i], p + i * stride, 8);
+    return _mm256_set_epi64x(runs[3], runs[2], runs[1], runs[0]);
+  }
+  inline void StoreRuns(uint16_t* p, UINT stride, Lanes a) {
+    alignas(32) int64_t runs[4];
+    _mm256_store_si256((__m256i*)runs, a);
+    for (UINT i = 0; i < 4; ++i) std::memcpy(p + i * stride, &runs[i], 8);
+  }
+
+  // Bits set in at least one lane and in at least two, in every lane.
+  // Each step folds the lanes onto their neighbours at half the distance.
+  inline void Fold(Lanes& once, Lanes& twice, Lanes o, Lanes t) {
+    twice = Or(Or(twice, t), And(once, o));
+    once = Or(once, o);
+  }
+  inline void Counts(Lanes a, Lanes& once, Lanes& twice) {
+    once = a;
+    twice = Zero();
+    Fold(once, twice, _mm256_permute2x128_si256(once, once, 1),
+         _mm256_permute2x128_si256(twice, twice, 1));
+    Fold(once, twice, _mm256_shuffle_epi32(once, 0x4E), _mm256_shuffle_epi32(twice, 0x4E));
+    Fold(once, twice, _mm256_shuffle_epi32(once, 0xB1), _mm256_shuffle_epi32(twice, 0xB1));
+    Fold(once, twice,
+         _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(once, 0xB1), 0xB1),
+         _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(twice, 0xB1), 0xB1));
+  }
+  // As above, and bits set in at least three lanes
+  inline void Fold(Lanes& once, Lanes& twice, Lanes& more, Lanes o, Lanes t, Lanes m) {
+    more = Or(Or(more, m), Or(And(twice, o), And(once, t)));
+    Fold(once, twice, o, t);
+  }
+  inline void Counts(Lanes a, Lanes& once, Lanes& twice, Lanes& more) {
+    once = a;
+    twice = more = Zero();
+    Fold(once, twice, more, _mm256_permute2x128_si256(once, once, 1),
+         _mm256_permute2x128_si256(twice, twice, 1), _mm256_permute2x128_si256(more, more, 1));
+    Fold(once, twice, more, _mm256_shuffle_epi32(once, 0x4E),
+         _mm256_shuffle_epi32(twice, 0x4E), _mm256_shuffle_epi32(more, 0x4E));
+    Fold(once, twice, more, _mm256_shuffle_epi32(once, 0xB1),
+         _mm256_shuffle_epi32(twice, 0xB1), _mm256_shuffle_epi32(more, 0xB1));
+    Fold(once, twice, more,
+         _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(once, 0xB1), 0xB1),
+         _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(twice, 0xB1), 0xB1),
+         _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(more, 0xB1), 0xB1));
+  }
+
+  // Transpose a 16x16 grid of masks. The two 128 bit halves of each row
+  // are paired up so one 8x8 transpose works on two quarters at once.
+  inline void Transpose(const uint16_t* in, uint16_t* out) {
+    for (UINT half = 0; half < 2; ++half) {
+      Lanes x[8], a[8], b[8];
+      for (UINT i = 0; i < 8; ++i) {
+        Lanes top = LoadLanes(in + 16 * i), bottom = LoadLanes(in + 16 * (i + 8));
+        x[i] = half ? _mm256_permute2x128_si256(top, bottom, 0x31)
+                    : _mm256_permute2x128_si256(top, bottom, 0x20);
+      }
+      a[0] = _mm256_unpacklo_epi16(x[0], x[1]);
+      a[1] = _mm256_unpackhi_epi16(x[0], x[1]);
+      a[2] = _mm256_unpacklo_epi16(x[2], x[3]);
+      a[3] = _mm256_unpackhi_epi16(x[2], x[3]);
+      a[4] = _mm256_unpacklo_epi16(x[4], x[5]);
+      a[5] = _mm256_unpackhi_epi16(x[4], x[5]);
+      a[6] = _mm256_unpacklo_epi16(x[6], x[7]);
+      a[7] = _mm256_unpackhi_epi16(x[6], x[7]);
+      b[0] = _mm256_unpacklo_epi32(a[0], a[2]);
+      b[1] = _mm256_unpackhi_epi32(a[0], a[2]);
+      b[2] = _mm256_unpacklo_epi32(a[1], a[3]);
+      b[3] = _mm256_unpackhi_epi32(a[1], a[3]);
+      b[4] = _mm256_unpacklo_epi32(a[4], a[6]);
+      b[5] = _mm256_unpackhi_epi32(a[4], a[6]);
+      b[6] = _mm256_unpacklo_epi32(a[5], a[7]);
+      b[7] = _mm256_unpackhi_epi32(a[5], a[7]);
+      uint16_t* rows = out + 128 * half;
+      for (UINT i = 0; i < 4; ++i) {
+        StoreLanes(rows + 16 * (2 * i), _mm256_unpacklo_epi64(b[i], b[i + 4]));
+        StoreLanes(rows + 16 * (2 * i + 1), _mm256_unpackhi_epi64(b[i], b[i + 4]));
+      }
+    }
+  }
+#else
+  struct Lanes { uint16_t v[COUNT]; };
+
+#define EACH_LANE(expr)\
+  Lanes r; for (UINT i = 0; i < COUNT; ++i) r.v[i] = (expr); return r;
+
+  inline Lanes LoadLanes(const uint16_t* p) { Lanes r; std::memcpy(r.v, p, sizeof(r.v)); return r; }
+  inline void StoreLanes(uint16_t* p, Lanes a) { std::memcpy(p, a.v, sizeof(a.v)); }
+  inline Lanes Fill(uint16_t v) { EACH_LANE(v) }
+  inline Lanes Zero() { return Fill(0); }
+  inline Lanes And(Lanes a, Lanes b) { EACH_LANE(a.v[i] & b.v[i]) }
+  inline Lanes Or(Lanes a, Lanes b) { EACH_LANE(a.v[i] | b.v[i]) }
+  inline Lanes Xor(Lanes a, Lanes b) { EACH_LANE(a.v[i] ^ b.v[i]) }
+  inline Lanes AndNot(Lanes a, Lanes b) { EACH_LANE(a.v[i] & ~b.v[i]) }
+  inline Lanes IsZero(Lanes a) { EACH_LANE(a.v[i] ? 0 : 0xFFFF) }
+  inline Lanes Single(Lanes a) { EACH_LANE((a.v[i] & (a.v[i] - 1)) ? 0 : a.v[i]) }
+  inline Lanes Narrow(Lanes a, Lanes b) { EACH_LANE(b.v[i] ? b.v[i] : a.v[i]) }
+  inline bool Any(Lanes a) {
+    uint16_t any = 0;
+    for (UINT i = 0; i < COUNT; ++i) any |= a.v[i];
+    return any != 0;
+  }
+  inline uint16_t First(Lanes a) { return a.v[0]; }
+  inline Lanes LoadRuns(const uint16_t* p, UINT stride) {
+    Lanes r;
+    for (UINT i = 0; i < 4; ++i) std::memcpy(r.v + 4 * i, p + i * stride, 8);
+    return r;
+  }
+  inline void StoreRuns(uint16_t* p, UINT stride, Lanes a) {
+    for (UINT i = 0; i < 4; ++i) std::memcpy(p + i * stride, a.v + 4 * i, 8);
+  }
+  inline void Counts(Lanes a, Lanes& once, Lanes& twice) {
+    uint16_t o = 0, t = 0;
+    for (UINT i = 0; i < COUNT; ++i) {
+      t |= o & a.v[i];
+      o |= a.v[i];
+    }
+    once = Fill(o);
+    twice = Fill(t);
+  }
+  inline void Counts(Lanes a, Lanes& once, Lanes& twice, Lanes& more) {
+    uint16_t o = 0, t = 0, m = 0;
+    for (UINT i = 0; i < COUNT; ++i) {
+      m |= t & a.v[i];
+      t |= o & a.v[i];
+      o |= a.v[i];
+    }
+    once = Fill(o);
+    twice = Fill(t);
+    more = Fill(m);
+  }
+  inline void Transpose(const uint16_t* in, uint16_t* out) {
+    for (UINT r = 0; r < COUNT; ++r) {
+      for (UINT c = 0; c < COUNT; ++c) out[c * COUNT + r] = in[r * COUNT + c];
+    }
+  }
+#undef EACH_LANE
+#endif
+}
+
+#endif /* SUDOKUSOLVER_LANES_HPP */
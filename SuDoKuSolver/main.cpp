@@ -7,59 +7,232 @@
 //
 #include <algorithm>
 #include <fstream>
-#include <iomanip>
+#include <memory>
 #include <iostream>
 #include <random>
-#include <set>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include <chrono>
 
 #include "spdlog/spdlog.h"
 
+#include "batch_solver.hpp"
+#include "columns.hpp"
+#include "dispatch.hpp"
 #include "grid.hpp"
+#include "histogram.hpp"
+#include "perf_counters.hpp"
+#include "service.hpp"
+#include "pipeline.hpp"
+#include "timeline.hpp"
 #include "solver.hpp"
+#include "writer.hpp"
 
 int main(int argc, const char * argv[]) {
   auto log = spdlog::stderr_logger_st("logger");
   spdlog::set_level(spdlog::level::debug);
   log->set_pattern("%v");
-  std::vector<std::string> grids_3x3;
-  std::ifstream infile("solveable.txt");
-  std::ofstream outfile("solveable_dat.txt");
-  std::string grid;
-  while (std::getline(infile, grid)) {
-    if (grid[0] == '#') {
-      outfile << grid << std::endl;
-      continue;
-    }
-    grids_3x3.emplace_back(grid.substr(0,81));
+  // --instruments FILE writes per technique stats, as CSV when FILE ends
+  // in .csv and JSON otherwise. Needs a USE_INSTRUMENTATION build.
+  // --report-every N prints latency percentiles for each N puzzles solved
+  // --timeline FILE writes the most recent solver events as a Chrome trace.
+  // Needs a USE_TIMELINE build.
+  std::string instruments_file, timeline_file, columns_file;
+  // --perf adds hardware counts around each solve to solveable_dat.txt,
+  // and per technique to the instruments. Totals are reported for the
+  // search (the 9x9 batches and other sizes' solves) and for grading.
+  // --deadline-ms N and --node-limit N bound each first attempt. Puzzles
+  // that run out go to the back of the queue to be solved without limits.
+  // Grading counts a node per round of techniques and per partial pattern
+  // overlay builds; other sizes count search nodes.
+  // --blanks CHARS and --separators CHARS read other puzzle dialects
+  // --top K lists the K slowest and highest scoring 9x9 puzzles
+  // --columns FILE also writes the 9x9 grading results as binary columns
+  UINT report_every = 0, deadline_ms = 0, top = 10;
+  std::string blanks = ".", separators;
+  SolveLimits limits;
+  // --serve answers requests on stdin until it closes, see service.hpp,
+  // instead of grading solveable.txt
+  bool use_perf = false, serve = false;
+  for (int i = 1; i < argc; ++i) {
+    if (std::string(argv[i]) == "--perf") use_perf = true;
+    if (std::string(argv[i]) == "--serve") serve = true;
+  }
+  for (int i = 1; i + 1 < argc; ++i) {
+    if (std::string(argv[i]) == "--instruments") instruments_file = argv[i + 1];
+    if (std::string(argv[i]) == "--report-every") report_every = std::stoul(argv[i + 1]);
+    if (std::string(argv[i]) == "--timeline") timeline_file = argv[i + 1];
+    if (std::string(argv[i]) == "--deadline-ms") deadline_ms = std::stoul(argv[i + 1]);
+    if (std::string(argv[i]) == "--node-limit") limits.nodes = std::stoull(argv[i + 1]);
+    if (std::string(argv[i]) == "--blanks") blanks = argv[i + 1];
+    if (std::string(argv[i]) == "--separators") separators = argv[i + 1];
+    if (std::string(argv[i]) == "--top") top = std::stoul(argv[i + 1]);
+    if (std::string(argv[i]) == "--columns") columns_file = argv[i + 1];
+  }
+  const PuzzleDialect dialect(blanks, separators, true);
+  if (serve) {
+    std::ios::sync_with_stdio(false);
+    GradingService service(dialect);
+    service.Serve(std::cin, std::cout);
+    return 0;
   }
-  infile.close();
-//  log->info("{} grids loaded from file.", grids_3x3.size());
-  
-//    grids_3x3.clear();
-//    grids_3x3.push_back("142895763..62.3.1...361...28671293..3514..82992453867167.3.129.23.9..1.7419782536");
   typedef std::chrono::high_resolution_clock::time_point Time;
-  typedef std::chrono::high_resolution_clock::duration Duration;
   
-  std::set<std_x::triple<Duration, std::string, UINT>> uniques;
+  // Each line starts with a puzzle of any size in gridsizes.itm, sized by
+  // its number of cells or an "HxW:" header, and anything after whitespace
+  // is ignored. Lines are read, solved and written in a pipeline, passing
+  // chunks of records through a bounded queue, so only a few chunks are
+  // held at once and results reach the file as they are done. Cells in
+  // the default dialect are used where they are in the line; others are
+  // rewritten once, for the 9x9 batch and the output.
+  struct Record {
+    std::string line;
+    std::string rewritten;
+    UINT begin, length;  // the cells in line
+    UINT size;    // NUM_GRID_SIZES for comments and unknown sizes
+    uint64_t id;  // line number in the input
+    uint64_t search_ns;  // for 9x9, its share of the chunk's batch solve
+    std::string_view Cells() const {
+      return rewritten.empty() ? std::string_view(line).substr(begin, length) : rewritten;
+    }
+  };
+  typedef std::vector<Record> Chunk;
+  const UINT CHUNK = 1024;
+  const bool rewrite = blanks != "." || !separators.empty();
+  BoundedQueue<Chunk> chunks(4);
+  std::thread reader([&chunks, &dialect, rewrite] {
+    std::ifstream infile("solveable.txt");
+    Chunk chunk;
+    Record record;
+    uint64_t line = 0;
+    while (std::getline(infile, record.line)) {
+      record.id = ++line;
+      record.search_ns = 0;
+      if (record.line.empty()) continue;
+      std::string_view cells;
+      record.size = record.line[0] == '#' ? NUM_GRID_SIZES
+                                          : DetectSize(record.line, cells, dialect);
+      record.begin = record.length = 0;
+      record.rewritten.clear();
+      if (record.size < NUM_GRID_SIZES) {
+        record.begin = (UINT)(cells.data() - record.line.data());
+        record.length = (UINT)cells.size();
+        if (rewrite) Normalise(cells, dialect, record.rewritten);
+      }
+      chunk.push_back(std::move(record));
+      if (chunk.size() < CHUNK) continue;
+      if (!chunks.Push(std::move(chunk))) return;
+      chunk = Chunk();
+    }
+    if (!chunk.empty()) chunks.Push(std::move(chunk));
+    chunks.Close();
+  });
+  
+  LatencyReport latencies, interval;
+  UINT max_Score = 0, min_score = 20000;
 //  UINT valids = 0;
   std::array<UINT, 15> counts;
   for (UINT& i : counts) i = 0;
+  Instruments instruments;
+  if (!timeline_file.empty()) Timeline::Enable();
+  PerfCounters perf;
+  PerfSample perf_start, perf_end, perf_total;
+  PerfSample search_start, search_end, search_total;
+  if (use_perf && !perf.Available()) {
+    log->warn("Hardware counters unavailable, carrying on without them");
+    use_perf = false;
+  }
+  TopK<uint64_t, std::string> slowest(top), hardest_scores(top);
   
-  for (std::string& g : grids_3x3) {
+  // Result lines are formatted in bulk and written from another thread
+  std::ofstream outfile("solveable_dat.txt");
+  ResultWriter writer(outfile);
+  std::ostringstream counters;
+  std::ofstream columns_out;
+  std::unique_ptr<GradeColumns> columns;
+  if (!columns_file.empty()) {
+    columns_out.open(columns_file, std::ios::binary);
+    columns.reset(new GradeColumns(columns_out));
+  }
+  GradeRow row;
+  
+  BatchSolver batch;
+  std::vector<std::string> grids_3x3;
+  std::vector<BatchSolver::Result> results;
+  UINT solved = 0, requeued = 0;
+  bool limited = deadline_ms || limits.nodes;
+  // Puzzles that ran out of limits, solved again without them at the end.
+  // Only 9x9 puzzles have a batch answer.
+  std::vector<std::pair<Record, BatchSolver::Result>> retries;
+  // Limits for a first attempt starting now
+  auto first_limits = [&] {
+    limits.deadline = SolveLimits::Clock::now() + std::chrono::milliseconds(deadline_ms);
+    if (!deadline_ms) limits.deadline = SolveLimits::Clock::time_point::max();
+    return limits;
+  };
+  
+  // Grades one 9x9 puzzle, reusing its batch answer. False if it ran out
+  // of limits.
+  auto grade = [&](const Record& r, const BatchSolver::Result& result, bool retry) {
+    std::string_view g = r.Cells();
     Time start = std::chrono::high_resolution_clock::now();
-    SudokuGrid<3> G2(g);
+    ParseResult parsed;
+    SudokuGrid<3> G2(g, PuzzleDialect::Default(), parsed);
+    G2.SetSolvedState(result.solved, result.unique, result.score);
     LogicalSolver<3> solver(G2);
+    if (limited && !retry) solver.SetLimits(first_limits());
+    if (use_perf) {
+      solver.SetPerfCounters(&perf);
+      perf.Read(perf_start);
+    }
     solver.Solve();
+    if (use_perf) perf.Read(perf_end);
+    if (solver.GetResult() == SolveResult::UNKNOWN) return false;
     UINT s = G2.GetScore();
     Time end = std::chrono::high_resolution_clock::now();
-    uniques.emplace(end - start, g, s);
     auto ops = solver.LogicalOperations();
-    switch (*std::max_element(ops.begin(), ops.end())) {
+    LogicOperation hardest = ops.empty() ? LogicOperation::NUM_OPERATIONS
+                                         : *std::max_element(ops.begin(), ops.end());
+    uint64_t t = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()
+      + r.search_ns;
+    interval.Record(9, hardest, t);
+    slowest.Offer(t, g);
+    hardest_scores.Offer(s, g);
+    instruments += solver.GetInstruments();
+    auto dots = std::count(g.begin(), g.end(), '.');
+    writer.Put(g).Put(" # ").PutUint(t / 1000).Put(' ').PutUint(81 - dots).Put(' ').PutUint(s);
+    if (use_perf) {
+      perf_total += perf_end - perf_start;
+      counters.str("");
+      perf.Write(counters << " ", perf_end - perf_start);
+      writer.Put(counters.str());
+    }
+    writer.EndLine();
+    if (columns) {
+      row.id = r.id;
+      row.clues = (uint8_t)(81 - dots);
+      row.score = (uint32_t)s;
+      row.hardest = hardest;
+      row.techniques.fill(0);
+      for (LogicOperation op : ops) ++row.techniques[(UINT)op];
+      row.nanoseconds = t;
+      ParseValues(g, PuzzleDialect::Default(), 81, 9, row.puzzle.data());
+      for (UINT i = 0; i < 81; ++i)
+        row.solution[i] = result.unique ? __find_first(result.solved[i]) + 1 : 0;
+      columns->Write(row);
+    }
+    if (s > max_Score) max_Score = s;
+    if (s < min_score) min_score = s;
+    if (report_every && ++solved % report_every == 0) {
+      std::cout << "# Solved " << solved << std::endl;
+      interval.Write(std::cout);
+      latencies += interval;
+      interval.Reset();
+    }
+    switch (hardest) {
       case LogicOperation::NAKED_SINGLE:
         ++counts[0];
         break;
@@ -106,30 +279,108 @@ int main(int argc, const char * argv[]) {
       default:
         break;
     }
-//    if (uniques.size() == 1000) break;
+    return true;
+  };
+  
+  // Other sizes are only solved, so their hardest operation is unknown.
+  // False if it ran out of limits.
+  SizeDispatcher dispatcher;
+  DispatchResult dispatched;
+  auto dispatch = [&](const Record& r, bool retry) {
+    std::string_view cells = r.Cells();
+    Time start = std::chrono::high_resolution_clock::now();
+    if (use_perf) perf.Read(search_start);
+    bool read = dispatcher.Solve(r.size, cells, dispatched,
+                                 limited && !retry ? first_limits() : SolveLimits());
+    if (use_perf) perf.Read(search_end);
+    Time end = std::chrono::high_resolution_clock::now();
+    if (use_perf) search_total += search_end - search_start;
+    const GridSize& size = GRID_SIZES[r.size];
+    if (!read) {
+      log->warn("Could not read {}x{} puzzle {}", size.h, size.w, std::string(cells));
+      return true;
+    }
+    if (dispatched.result == SolveResult::UNKNOWN) return false;
+    auto t = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    interval.Record(size.h * size.w, LogicOperation::NUM_OPERATIONS, t);
+    auto dots = std::count(cells.begin(), cells.end(), '.');
+    writer.PutUint(size.h).Put('x').PutUint(size.w).Put(':').Put(cells)
+    .Put(" # ").PutUint(t / 1000).Put(' ').PutUint(size.n - dots).Put(' ')
+    .PutUint(dispatched.score);
+    if (use_perf) {
+      counters.str("");
+      perf.Write(counters << " ", search_end - search_start);
+      writer.Put(counters.str());
+    }
+    writer.EndLine();
+    return true;
+  };
+  
+  Chunk chunk;
+  while (chunks.Pop(chunk)) {
+    // Solve the chunk's 9x9 grids in SIMD batches, grading reuses the answers
+    grids_3x3.clear();
+    for (const Record& r : chunk) {
+      if (r.size < NUM_GRID_SIZES && GRID_SIZES[r.size].h == 3 && GRID_SIZES[r.size].w == 3)
+        grids_3x3.emplace_back(r.Cells());
+    }
+    Time batch_start = std::chrono::high_resolution_clock::now();
+    if (use_perf) perf.Read(search_start);
+    batch.Solve(grids_3x3, results);
+    if (use_perf) {
+      perf.Read(search_end);
+      search_total += search_end - search_start;
+    }
+    // Each puzzle's time includes an even share of its batch, so times
+    // and histograms cover the search as well as grading
+    uint64_t share = grids_3x3.empty() ? 0 :
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::high_resolution_clock::now() - batch_start).count() / grids_3x3.size();
+    
+    UINT next = 0;
+    for (Record& r : chunk) {
+      if (r.line[0] == '#') {
+        writer.Put(r.line).EndLine();
+      } else if (r.size == NUM_GRID_SIZES) {
+        log->warn("No grid size fits {}", r.line);
+      } else if (GRID_SIZES[r.size].h == 3 && GRID_SIZES[r.size].w == 3) {
+        const BatchSolver::Result& result = results[next++];
+        r.search_ns = share;
+        if (!grade(r, result, false)) {
+          retries.emplace_back(r, result);
+          ++requeued;
+        }
+      } else if (!dispatch(r, false)) {
+        retries.emplace_back(r, BatchSolver::Result());
+        ++requeued;
+      }
+    }
   }
-  UINT max_Score = 0, min_score = 20000;
-  uint64_t runtime = 0;
-  for (auto& s : uniques) {
-    auto t = std::chrono::duration_cast<std::chrono::microseconds>(s.first).count();
-    runtime += t;
-    auto dots = std::count(s.second.begin(), s.second.end(), '.');
-    outfile << s.second << " # " << std::setfill('0') << std::setw(3)
-    << (t % 1000000000) / 1000000 << "::" << std::setw(3)
-    << (t % 1000000) / 1000 << "::" << std::setw(3)
-    << t % 1000 << " " << 81 - dots << " " << s.third << std::endl;
-    if (s.third > max_Score) max_Score = s.third;
-    if (s.third < min_score) min_score = s.third;
+  reader.join();
+  for (auto& retry : retries) {
+    const GridSize& size = GRID_SIZES[retry.first.size];
+    if (size.h == 3 && size.w == 3) grade(retry.first, retry.second, true);
+    else dispatch(retry.first, true);
   }
-  outfile << "# Total time: " << std::setfill('0') << std::setw(3)
-  << (runtime % 1000000000) / 1000000 << "::" << std::setw(3)
-  << (runtime % 1000000) / 1000 << "::" << std::setw(3)
-  << runtime % 1000 << std::endl;
-  std::cout << "# Total time: " << std::setfill('0') << std::setw(3)
-  << (runtime % 1000000000) / 1000000 << "::" << std::setw(3)
-  << (runtime % 1000000) / 1000 << "::" << std::setw(3)
-  << runtime % 1000 << std::endl;
+  if (columns) columns->Close();
+  latencies += interval;
+  
+  // Per puzzle times above are in microseconds, as is the total
+  uint64_t runtime = 0;
+  for (auto& h : latencies.Histograms()) runtime += h.second.GetTotal() / 1000;
+  writer.Close();
+  outfile << "# Total time: " << runtime << " us" << std::endl;
   outfile.close();
+  std::cout << "# Total time: " << runtime << " us" << std::endl;
+  latencies.Write(std::cout);
+  if (use_perf) {
+    std::cout << "# Counters (";
+    for (UINT e = 0; e < NUM_PERF_EVENTS; ++e)
+      std::cout << (e ? " " : "") << PerfEventName((PerfEvent)e);
+    std::cout << ")" << std::endl;
+    perf.Write(std::cout << "# Search: ", search_total) << std::endl;
+    perf.Write(std::cout << "# Grading: ", perf_total) << std::endl;
+  }
   
   std::cout << "Minimum score: " << min_score << std::endl;
   std::cout << "Maximum score: " << max_Score << std::endl;
@@ -148,6 +399,27 @@ int main(int argc, const char * argv[]) {
   std::cout << "Pattern overlay: " << counts[12] << std::endl;
   std::cout << "Brute force: " << counts[13] << std::endl;
   std::cout << "Brute force only: " << counts[14] << std::endl;
+  if (limited) std::cout << "Requeued: " << requeued << std::endl;
+  if (top) {
+    std::cout << "# Slowest puzzles (us)" << std::endl;
+    for (auto& p : slowest.Sorted()) std::cout << p.second << " " << p.first / 1000 << std::endl;
+    std::cout << "# Highest scores" << std::endl;
+    for (auto& p : hardest_scores.Sorted()) std::cout << p.second << " " << p.first << std::endl;
+  }
+  
+  if (!instruments_file.empty()) {
+    std::ofstream stats(instruments_file);
+    const std::string csv = ".csv";
+    if (instruments_file.size() >= csv.size() &&
+        instruments_file.compare(instruments_file.size() - csv.size(), csv.size(), csv) == 0)
+      instruments.WriteCsv(stats);
+    else
+      instruments.WriteJson(stats);
+  }
+  if (!timeline_file.empty()) {
+    std::ofstream trace(timeline_file);
+    Timeline::WriteChromeTrace(trace);
+  }
   
   return 0;
 }
@@ -0,0 +1,55 @@
+//
+//  operations.hpp
+//  SuDoKuSolver
+//
+//  Copyright © 2018 Hermes Productions. All rights reserved.
+//
+
+#ifndef SUDOKUSOLVER_OPERATIONS_HPP
+#define SUDOKUSOLVER_OPERATIONS_HPP
+
+#include "defines.hpp"
+
+enum class LogicOperation {
+  NAKED_SINGLE,
+  HIDDEN_SINGLE,
+  NAKED_PAIR,
+  HIDDEN_PAIR,
+  NAKED_TRIPLE,
+  HIDDEN_TRIPLE,
+  NAKED_QUAD,
+  HIDDEN_QUAD,
+  NAKED_NUPLE,        // For larger grids
+  HIDDEN_NUPLE,
+  INTERSECTION_REMOVAL,
+  BUG_REMOVAL,
+  PATTERN_OVERLAY,
+  BRUTE_FORCE,         // Last resort
+  NUM_OPERATIONS
+};
+
+enum class Action {
+  REMOVE,
+  COMPLETE,
+};
+
+const UINT NUM_OPERATIONS = (UINT)LogicOperation::NUM_OPERATIONS;
+
+// Short lower case name of an operation, for reports
+inline const char* OperationName(LogicOperation op) {
+  static const char* names[NUM_OPERATIONS + 1] = {
+    "naked_single", "hidden_single", "naked_pair", "hidden_pair",
+    "naked_triple", "hidden_triple", "naked_quad", "hidden_quad",
+    "naked_nuple", "hidden_nuple", "intersection_removal", "bug_removal",
+    "pattern_overlay", "brute_force", "none"
+  };
+  return names[(UINT)op];
+}
+
+// The naked or hidden operation for a subset of the given size
+inline LogicOperation NupleOperation(bool hidden, UINT nuple) {
+  if (nuple > 4) nuple = 5;
+  return (LogicOperation)((UINT)LogicOperation::NAKED_PAIR + 2 * (nuple - 2) + hidden);
+}
+
+#endif /* SUDOKUSOLVER_OPERATIONS_HPP */
@@ -0,0 +1,144 @@
+//
+//  parser.cpp
+//  SuDoKuSolver
+//
+//  Copyright © 2018 Hermes Productions. All rights reserved.
+//
+
+#include "parser.hpp"
+
+#include <algorithm>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+const char VALUE_CHARS[] =
+  "1234567890ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+
+const char* ParseErrorName(ParseError e) {
+  switch (e) {
+    case ParseError::NONE: return "none";
+    case ParseError::TOO_SHORT: return "too_short";
+    case ParseError::TOO_LONG: return "too_long";
+    case ParseError::BAD_CHARACTER: return "bad_character";
+    case ParseError::VALUE_TOO_LARGE: return "value_too_large";
+    case ParseError::CONFLICT: return "conflict";
+  }
+  return "unknown";
+}
+
+PuzzleDialect::PuzzleDialect(std::string_view blanks, std::string_view separators,
+                             bool metadata)
+: _metadata(metadata) {
+  _table.fill(BAD);
+  for (UINT v = 0; VALUE_CHARS[v]; ++v) _table[(unsigned char)VALUE_CHARS[v]] = (uint8_t)(v + 1);
+  // Cells end at whitespace when something can follow them
+  if (metadata) {
+    for (char c : std::string_view(" \t\r\n")) _table[(unsigned char)c] = END;
+  }
+  for (char c : separators) _table[(unsigned char)c] = SKIP;
+  for (char c : blanks) _table[(unsigned char)c] = BLANK;
+  _blanks[0] = blanks.empty() ? '.' : blanks[0];
+  _blanks[1] = blanks.size() > 1 ? blanks[1] : _blanks[0];
+}
+
+const PuzzleDialect& PuzzleDialect::Default() {
+  static const PuzzleDialect dialect;
+  return dialect;
+}
+
+namespace {
+#ifdef __SSE2__
+  // Sixteen cells at once when they are all blanks or digits up to max,
+  // the usual case up to 9x9. False, having written nothing, otherwise.
+  inline bool ParseChunk(const char* in, const PuzzleDialect& dialect, UINT max,
+                         uint8_t* out) {
+    __m128i c = _mm_loadu_si128((const __m128i*)in);
+    __m128i d = _mm_sub_epi8(c, _mm_set1_epi8('1'));
+    // Unsigned d <= max - 1 picks out '1' up to the largest allowed digit
+    __m128i limit = _mm_set1_epi8((char)(std::min(max, (UINT)9) - 1));
+    __m128i digit = _mm_cmpeq_epi8(_mm_min_epu8(d, limit), d);
+    __m128i blank = _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8(dialect.Blank(0))),
+                                 _mm_cmpeq_epi8(c, _mm_set1_epi8(dialect.Blank(1))));
+    if (_mm_movemask_epi8(_mm_or_si128(digit, blank)) != 0xFFFF) return false;
+    __m128i v = _mm_and_si128(_mm_add_epi8(d, _mm_set1_epi8(1)), digit);
+    _mm_storeu_si128((__m128i*)out, _mm_andnot_si128(blank, v));
+    return true;
+  }
+#endif
+
+  inline ParseResult Result(ParseError e, UINT pos) { return {e, pos, std::string_view()}; }
+
+  // What follows the cells, from the first character that isn't whitespace
+  // or a separator
+  ParseResult Trailing(std::string_view s, UINT pos, const PuzzleDialect& dialect) {
+    for (; pos < s.size(); ++pos) {
+      uint8_t v = dialect.Map(s[pos]);
+      if (v == PuzzleDialect::SKIP || v == PuzzleDialect::END) continue;
+      if (dialect.HasMetadata()) return {ParseError::NONE, pos, s.substr(pos)};
+      return Result(ParseError::TOO_LONG, pos);
+    }
+    return Result(ParseError::NONE, pos);
+  }
+}
+
+ParseResult ParseValues(std::string_view s, const PuzzleDialect& dialect, UINT n,
+                        UINT max, uint8_t* out) {
+  UINT pos = 0, count = 0;
+  while (count < n) {
+#ifdef __SSE2__
+    while (count + 16 <= n && pos + 16 <= s.size()
+           && ParseChunk(s.data() + pos, dialect, max, out + count)) {
+      pos += 16;
+      count += 16;
+    }
+#endif
+    if (count == n) break;
+    if (pos == s.size()) return Result(ParseError::TOO_SHORT, pos);
+    // Up to a chunk one at a time, then try whole chunks again
+    UINT stop = std::min(s.size(), (size_t)pos + 16);
+    for (; pos < stop && count < n; ++pos) {
+      uint8_t v = dialect.Map(s[pos]);
+      if (v == PuzzleDialect::SKIP) continue;
+      if (v == PuzzleDialect::END) return Result(ParseError::TOO_SHORT, pos);
+      if (v == PuzzleDialect::BAD) return Result(ParseError::BAD_CHARACTER, pos);
+      if (v > max) return Result(ParseError::VALUE_TOO_LARGE, pos);
+      out[count++] = v;
+    }
+  }
+  return Trailing(s, pos, dialect);
+}
+
+ParseResult CountCells(std::string_view s, const PuzzleDialect& dialect, UINT& n) {
+  UINT pos = 0;
+  n = 0;
+#ifdef __SSE2__
+  uint8_t chunk[16];
+  while (pos + 16 <= s.size() && ParseChunk(s.data() + pos, dialect, 9, chunk)) {
+    pos += 16;
+    n += 16;
+  }
+#endif
+  for (; pos < s.size(); ++pos) {
+    uint8_t v = dialect.Map(s[pos]);
+    if (v == PuzzleDialect::SKIP) continue;
+    if (v == PuzzleDialect::END) break;
+    if (v == PuzzleDialect::BAD) return Result(ParseError::BAD_CHARACTER, pos);
+    ++n;
+  }
+  return Result(ParseError::NONE, pos);
+}
+
+ParseResult Normalise(std::string_view s, const PuzzleDialect& dialect, std::string& cells) {
+  cells.clear();
+  UINT pos = 0;
+  for (; pos < s.size(); ++pos) {
+    uint8_t v = dialect.Map(s[pos]);
+    if (v == PuzzleDialect::SKIP) continue;
+    if (v == PuzzleDialect::END) break;
+    if (v == PuzzleDialect::BAD) return Result(ParseError::BAD_CHARACTER, pos);
+    cells.push_back(CellChar(v));
+  }
+  return Trailing(s, pos, dialect);
+}
@@ -0,0 +1,85 @@
+//
+//  parser.hpp
+//  SuDoKuSolver
+//
+//  Copyright © 2018 Hermes Productions. All rights reserved.
+//
+
+#ifndef SUDOKUSOLVER_PARSER_HPP
+#define SUDOKUSOLVER_PARSER_HPP
+
+#include "defines.hpp"
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Characters for values 1 to 62, the order SudokuGrid reads and writes them
+extern const char VALUE_CHARS[];
+
+// A cell's character in the default dialect, 0 being a blank
+inline char CellChar(UINT v) { return v ? VALUE_CHARS[v - 1] : '.'; }
+
+enum class ParseError {
+  NONE,
+  TOO_SHORT,        // fewer cells than the grid has
+  TOO_LONG,         // more cells, and the dialect has no metadata
+  BAD_CHARACTER,    // not a value, blank or separator
+  VALUE_TOO_LARGE,  // a value over the grid's largest
+  CONFLICT,         // a clue repeated in a group. The grid is still built.
+};
+
+const char* ParseErrorName(ParseError);
+
+// Where parsing stopped, and anything after the cells
+struct ParseResult {
+  ParseError error;
+  UINT position;            // offset into the input, or the cell of a conflict
+  std::string_view metadata;
+};
+
+// How puzzle text is written: which characters are blanks, which are
+// skipped, such as "|" or "-" in grids drawn on one line, and whether the
+// cells can be followed by whitespace and anything else. Built once and
+// shared, as it holds the character table parsing runs on.
+class PuzzleDialect {
+public:
+  // Table entries that aren't values
+  static const uint8_t BLANK = 0;
+  static const uint8_t SKIP = 0xFD;
+  static const uint8_t END = 0xFE;
+  static const uint8_t BAD = 0xFF;
+
+  PuzzleDialect(std::string_view blanks = ".", std::string_view separators = "",
+                bool metadata = false);
+  // "." blanks and exactly the cells, as the string constructor expects
+  static const PuzzleDialect& Default();
+
+  inline uint8_t Map(char c) const { return _table[(unsigned char)c]; }
+  inline bool HasMetadata() const { return _metadata; }
+  // Up to two blanks checked sixteen characters at a time
+  inline char Blank(UINT i) const { return _blanks[i]; }
+
+private:
+  std::array<uint8_t, 256> _table;
+  char _blanks[2];
+  bool _metadata;
+};
+
+// Reads n cell values, 0 for blanks, into out, allowing values up to max.
+// Never throws: errors come back in the result.
+ParseResult ParseValues(std::string_view, const PuzzleDialect&, UINT n, UINT max,
+                        uint8_t* out);
+
+// Counts the cells of any dialect without reading their values, for sizing
+// a record before it is parsed. The result's position is where the cells
+// end, before any whitespace and metadata.
+ParseResult CountCells(std::string_view, const PuzzleDialect&, UINT& n);
+
+// Rewrites the cells of any dialect as "." blanks and value characters,
+// for code that takes the default dialect. The number of cells isn't
+// checked, so this can run before the size is known.
+ParseResult Normalise(std::string_view, const PuzzleDialect&, std::string& cells);
+
+#endif /* SUDOKUSOLVER_PARSER_HPP */
@@ -0,0 +1,64 @@
+//
+//  perf_counters.cpp
+//  SuDoKuSolver
+//
+//  Copyright © 2018 Hermes Productions. All rights reserved.
+//
+
+#include "perf_counters.hpp"
+
+#ifdef __linux__
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+PerfCounters::PerfCounters() : _open(0) {
+  _fds.fill(-1);
+#ifdef __linux__
+  static const uint64_t configs[NUM_PERF_EVENTS] = {
+    PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES
+  };
+  for (UINT i = 0; i < NUM_PERF_EVENTS; ++i) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = configs[i];
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    // This thread, any CPU. Events open separately so one being
+    // unsupported doesn't lose the others.
+    _fds[i] = (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+    if (_fds[i] >= 0) ++_open;
+  }
+#endif
+}
+
+PerfCounters::~PerfCounters() {
+#ifdef __linux__
+  for (int fd : _fds) if (fd >= 0) close(fd);
+#endif
+}
+
+void PerfCounters::Read(PerfSample& sample) const {
+  for (UINT i = 0; i < NUM_PERF_EVENTS; ++i) {
+    sample.values[i] = 0;
+#ifdef __linux__
+    if (_fds[i] < 0) continue;
+    uint64_t value;
+    if (read(_fds[i], &value, sizeof(value)) == sizeof(value)) sample.values[i] = value;
+#endif
+  }
+}
+
+std::ostream& PerfCounters::Write(std::ostream& s, const PerfSample& sample) const {
+  for (UINT i = 0; i < NUM_PERF_EVENTS; ++i) {
+    if (i) s << " ";
+    if (_fds[i] >= 0) s << sample.values[i];
+    else s << "n/a";
+  }
+  return s;
+}
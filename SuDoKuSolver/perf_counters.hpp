@@ -0,0 +1,72 @@
+//
+//  perf_counters.hpp
+//  SuDoKuSolver
+//
+//  Copyright © 2018 Hermes Productions. All rights reserved.
+//
+
+#ifndef SUDOKUSOLVER_PERF_COUNTERS_HPP
+#define SUDOKUSOLVER_PERF_COUNTERS_HPP
+
+#include "defines.hpp"
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+
+enum class PerfEvent {
+  CYCLES,
+  INSTRUCTIONS,
+  CACHE_MISSES,
+  BRANCH_MISSES,
+  NUM_EVENTS
+};
+
+const UINT NUM_PERF_EVENTS = (UINT)PerfEvent::NUM_EVENTS;
+
+// Short lower case name of an event, for reports
+inline const char* PerfEventName(PerfEvent event) {
+  static const char* names[NUM_PERF_EVENTS] = {
+    "cycles", "instructions", "cache_misses", "branch_misses"
+  };
+  return names[(UINT)event];
+}
+
+// Counter values at a point, or between two points once subtracted
+struct PerfSample {
+  std::array<uint64_t, NUM_PERF_EVENTS> values = {};
+
+  inline uint64_t Get(PerfEvent event) const { return values[(UINT)event]; }
+  PerfSample operator-(const PerfSample& o) const {
+    PerfSample r;
+    for (UINT i = 0; i < NUM_PERF_EVENTS; ++i) r.values[i] = values[i] - o.values[i];
+    return r;
+  }
+  PerfSample& operator+=(const PerfSample& o) {
+    for (UINT i = 0; i < NUM_PERF_EVENTS; ++i) values[i] += o.values[i];
+    return *this;
+  }
+};
+
+// Hardware counters for the calling thread, through perf_event_open on
+// Linux. Events the kernel, the CPU or the permissions don't allow are
+// left out and read as zero; elsewhere nothing is ever available. Only
+// user space is counted, so perf_event_paranoid up to 2 is enough.
+class PerfCounters {
+public:
+  PerfCounters();
+  ~PerfCounters();
+  PerfCounters(const PerfCounters&) = delete;
+  PerfCounters& operator=(const PerfCounters&) = delete;
+  inline bool Available() const { return _open != 0; }
+  inline bool Available(PerfEvent event) const { return _fds[(UINT)event] >= 0; }
+  void Read(PerfSample&) const;
+  // Counts for the events that opened, n/a for the rest
+  std::ostream& Write(std::ostream&, const PerfSample&) const;
+
+private:
+  std::array<int, NUM_PERF_EVENTS> _fds;
+  UINT _open;
+};
+
+#endif /* SUDOKUSOLVER_PERF_COUNTERS_HPP */
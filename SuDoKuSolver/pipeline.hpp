@@ -0,0 +1,116 @@
+//
+//  pipeline.hpp
+//  SuDoKuSolver
+//
+//  Copyright © 2018 Hermes Productions. All rights reserved.
+//
+
+#ifndef SUDOKUSOLVER_PIPELINE_HPP
+#define SUDOKUSOLVER_PIPELINE_HPP
+
+#include "defines.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// Hands work between pipeline stages, holding at most capacity items so a
+// fast stage waits for a slow one instead of buffering everything. Push
+// waits while full and Pop while empty. Once closed, Pop drains what is
+// left and then returns false.
+template <class T>
+class BoundedQueue {
+public:
+  explicit BoundedQueue(UINT capacity) : _capacity(std::max(capacity, (UINT)1)) { }
+
+  // False, dropping the item, if the queue was closed
+  bool Push(T&& item) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _not_full.wait(lock, [this] { return _closed || _items.size() < _capacity; });
+    if (_closed) return false;
+    _items.push_back(std::move(item));
+    lock.unlock();
+    _not_empty.notify_one();
+    return true;
+  }
+
+  bool Pop(T& item) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _not_empty.wait(lock, [this] { return _closed || !_items.empty(); });
+    if (_items.empty()) return false;
+    item = std::move(_items.front());
+    _items.pop_front();
+    lock.unlock();
+    _not_full.notify_one();
+    return true;
+  }
+
+  // As Pop, but false straight away when nothing is waiting
+  bool TryPop(T& item) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (_items.empty()) return false;
+    item = std::move(_items.front());
+    _items.pop_front();
+    lock.unlock();
+    _not_full.notify_one();
+    return true;
+  }
+
+  void Close() {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _closed = true;
+    }
+    _not_full.notify_all();
+    _not_empty.notify_all();
+  }
+
+private:
+  std::deque<T> _items;
+  UINT _capacity;
+  bool _closed = false;
+  std::mutex _mutex;
+  std::condition_variable _not_full, _not_empty;
+};
+
+// The k items with the largest keys offered so far, kept in a min-heap so
+// each offer costs O(log k) and memory stays at k whatever the stream length
+template <class Key, class T>
+class TopK {
+public:
+  typedef std::pair<Key, T> Entry;
+
+  explicit TopK(UINT k) : _k(k) { _heap.reserve(k); }
+
+  // Anything T can be made from, such as a view of a T, only copied when kept
+  template <class U>
+  void Offer(const Key& key, const U& item) {
+    if (_heap.size() < _k) {
+      _heap.emplace_back(key, T(item));
+      std::push_heap(_heap.begin(), _heap.end(), Greater);
+    } else if (_k && _heap.front().first < key) {
+      std::pop_heap(_heap.begin(), _heap.end(), Greater);
+      _heap.back() = Entry(key, T(item));
+      std::push_heap(_heap.begin(), _heap.end(), Greater);
+    }
+  }
+
+  // Largest first
+  std::vector<Entry> Sorted() const {
+    std::vector<Entry> sorted(_heap);
+    std::sort(sorted.begin(), sorted.end(), Greater);
+    return sorted;
+  }
+
+private:
+  static bool Greater(const Entry& l, const Entry& r) { return r.first < l.first; }
+
+  std::vector<Entry> _heap;
+  UINT _k;
+};
+
+#endif /* SUDOKUSOLVER_PIPELINE_HPP */
@@ -0,0 +1,162 @@
+//
+//  service.cpp
+//  SuDoKuSolver
+//
+//  Copyright © 2018 Hermes Productions. All rights reserved.
+//
+
+#include "service.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#include "pipeline.hpp"
+#include "solver.hpp"
+
+namespace {
+  typedef std::chrono::steady_clock Clock;
+
+  inline uint64_t Micros(Clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count();
+  }
+
+  UINT Clues(std::string_view cells, const PuzzleDialect& dialect) {
+    UINT clues = 0;
+    for (char c : cells) {
+      uint8_t v = dialect.Map(c);
+      clues += v != PuzzleDialect::BLANK && v < PuzzleDialect::SKIP;
+    }
+    return clues;
+  }
+}
+
+GradingService::GradingService(const PuzzleDialect& dialect)
+: _dialect(dialect), _layout(std::string(81, '.')) { }
+
+void GradingService::Serve(std::istream& in, std::ostream& out) {
+  // Parsing requests overlaps with solving earlier ones
+  BoundedQueue<std::string> requests(256);
+  std::thread reader([&in, &requests] {
+    std::string line;
+    while (std::getline(in, line)) {
+      if (!line.empty() && !requests.Push(std::move(line))) break;
+    }
+    requests.Close();
+  });
+  ResultWriter writer(out);
+  std::string request;
+  while (true) {
+    if (!requests.TryPop(request)) {
+      writer.Flush();
+      if (!requests.Pop(request)) break;
+    }
+    Answer(request, writer);
+  }
+  reader.join();
+  writer.Close();
+}
+
+void GradingService::Answer(std::string_view request, ResultWriter& out) {
+  ServiceMode mode = ServiceMode::GRADE;
+  std::string_view puzzle = request;
+  size_t space = request.find(' ');
+  if (space != std::string_view::npos) {
+    std::string_view word = request.substr(0, space);
+    bool known = true;
+    if (word == "unique") mode = ServiceMode::UNIQUE;
+    else if (word == "grade") mode = ServiceMode::GRADE;
+    else if (word == "trace") mode = ServiceMode::TRACE;
+    else if (word == "hint") mode = ServiceMode::HINT;
+    else known = false;
+    if (known) {
+      puzzle = request.substr(space + 1);
+      puzzle.remove_prefix(std::min(puzzle.find_first_not_of(' '), puzzle.size()));
+    }
+  }
+
+  std::string_view cells;
+  ParseResult counted;
+  UINT size = DetectSize(puzzle, cells, counted, _dialect);
+  if (size == NUM_GRID_SIZES) {
+    out.Put("error ").Put(counted.error == ParseError::NONE ? "unknown_size"
+                                                             : ParseErrorName(counted.error))
+    .Put(' ').Put(request).EndLine();
+    return;
+  }
+  // The puzzle as sent, header and all, without anything after its cells
+  std::string_view sent = puzzle.substr(0, cells.data() + cells.size() - puzzle.data());
+  const GridSize& g = GRID_SIZES[size];
+  bool nines = g.h == 3 && g.w == 3;
+  if (nines && mode != ServiceMode::UNIQUE) {
+    Grade(mode, cells, sent, out);
+    return;
+  }
+  if (mode == ServiceMode::HINT) {
+    out.Put("error unsupported_size ").Put(request).EndLine();
+    return;
+  }
+
+  Clock::time_point start = Clock::now();
+  if (!_dispatcher.Solve(size, cells, _dispatched, SolveLimits(), _dialect)) {
+    out.Put("error bad_puzzle ").Put(request).EndLine();
+    return;
+  }
+  uint64_t us = Micros(start);
+  out.Put(sent);
+  bool solved = _dispatched.result == SolveResult::SOLVED;
+  if (mode == ServiceMode::UNIQUE) {
+    out.Put(solved ? " unique solved " : " unique unsolved").Put(_dispatched.solution);
+  } else {
+    out.Put(mode == ServiceMode::TRACE ? " trace " : " grade ");
+    if (!solved) out.Put("unsolved");
+    else out.PutUint(Clues(cells, _dialect)).Put(' ').PutUint(_dispatched.score).Put(" none ").PutUint(us);
+    if (solved && mode == ServiceMode::TRACE) out.Put(" :");
+  }
+  out.EndLine();
+}
+
+void GradingService::Grade(ServiceMode mode, std::string_view cells, std::string_view sent,
+                           ResultWriter& out) {
+  Clock::time_point start = Clock::now();
+  ParseResult parsed;
+  SudokuGrid<3> grid(cells, _dialect, parsed, _layout);
+  // Repeated clues leave no solution, as in unique mode and other sizes
+  if (parsed.error != ParseError::NONE && parsed.error != ParseError::CONFLICT) {
+    out.Put("error ").Put(ParseErrorName(parsed.error)).Put(' ').Put(sent).EndLine();
+    return;
+  }
+  out.Put(sent).Put(mode == ServiceMode::TRACE ? " trace " :
+                     mode == ServiceMode::HINT ? " hint " : " grade ");
+  if (parsed.error == ParseError::CONFLICT || !grid.IsSolvable()) {
+    out.Put("unsolved").EndLine();
+    return;
+  }
+  LogicalSolver<3> solver(grid);
+  if (mode == ServiceMode::HINT) {
+    // Only as far as the first technique that finds something
+    LogicalSolver<3>::Deduction step;
+    if (!solver.Next(step)) {
+      out.Put("none").EndLine();
+      return;
+    }
+    out.Put(OperationName(step.operation)).Put(" :");
+    for (auto& action : step.actions) {
+      out.Put(action.first == Action::REMOVE ? " -" : " +").Put(CellChar(action.second + 1))
+      .Put('@').PutUint(action.third);
+    }
+    out.EndLine();
+    return;
+  }
+  solver.Solve();
+  const std::vector<LogicOperation>& ops = solver.LogicalOperations();
+  LogicOperation hardest = ops.empty() ? LogicOperation::NUM_OPERATIONS
+                                       : *std::max_element(ops.begin(), ops.end());
+  out.PutUint(Clues(cells, _dialect)).Put(' ').PutUint(grid.GetScore()).Put(' ')
+  .Put(OperationName(hardest)).Put(' ').PutUint(Micros(start));
+  if (mode == ServiceMode::TRACE) {
+    out.Put(" :");
+    for (LogicOperation op : ops) out.Put(' ').Put(OperationName(op));
+  }
+  out.EndLine();
+}
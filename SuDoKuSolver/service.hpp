@@ -0,0 +1,69 @@
+//
+//  service.hpp
+//  SuDoKuSolver
+//
+//  Copyright © 2018 Hermes Productions. All rights reserved.
+//
+
+#ifndef SUDOKUSOLVER_SERVICE_HPP
+#define SUDOKUSOLVER_SERVICE_HPP
+
+#include "defines.hpp"
+
+#include <istream>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+#include "dispatch.hpp"
+#include "grid.hpp"
+#include "parser.hpp"
+#include "writer.hpp"
+
+// What a request asks for
+enum class ServiceMode {
+  UNIQUE,   // whether there is exactly one solution, and what it is
+  GRADE,    // score and hardest technique needed
+  TRACE,    // as GRADE, followed by every technique in the order used
+  HINT,     // the easiest next deduction, 9x9 only
+};
+
+// Answers newline delimited puzzle requests for as long as a process runs,
+// so start up, size set up and group layouts are paid for once. A request
+// is a puzzle in the service's dialect, after an optional mode word, and
+// each gets one response line, in order:
+//   [unique|grade|trace|hint] PUZZLE [ignored]
+//   PUZZLE unique solved SOLUTION | PUZZLE unique unsolved
+//   PUZZLE grade CLUES SCORE HARDEST MICROSECONDS
+//   PUZZLE trace CLUES SCORE HARDEST MICROSECONDS : TECHNIQUE...
+//   PUZZLE hint TECHNIQUE : -VALUE@CELL... +VALUE@CELL... | PUZZLE hint none
+//   error REASON REQUEST
+// Grade and trace answer "unsolved" for puzzles without one solution,
+// including those with repeated clues. A hint lists the candidates removed
+// (-) and cells completed (+), with cells counted from 0. "none" means only
+// brute force is left. Error reasons are ParseErrorName's, such as
+// bad_character, or unknown_size when no size has that many cells.
+// Puzzles other than 9x9 can have an "HxW:" header, and only 9x9 puzzles
+// are graded with techniques. Puzzles are echoed as sent, with any header
+// but without what follows the cells, and read once, straight from the
+// request.
+class GradingService {
+public:
+  explicit GradingService(const PuzzleDialect&);
+
+  // Reads requests on another thread while answering, until input ends.
+  // Output is flushed whenever no request is waiting.
+  void Serve(std::istream&, std::ostream&);
+  void Answer(std::string_view request, ResultWriter&);
+
+private:
+  // Cells are what is read, sent what is echoed
+  void Grade(ServiceMode, std::string_view cells, std::string_view sent, ResultWriter&);
+
+  const PuzzleDialect& _dialect;
+  SizeDispatcher _dispatcher;
+  DispatchResult _dispatched;
+  SudokuGrid<3> _layout;
+};
+
+#endif /* SUDOKUSOLVER_SERVICE_HPP */
@@ -7,9 +7,10 @@
 //
 
 #include "defines.hpp"
+#include <algorithm>
 #include <iostream>
 #include <list>
-#include <sstream>
+#include <random>
 #include <vector>
 
 #include "spdlog/spdlog.h"
@@ -28,129 +29,294 @@ _groups(grid.GetAllGroups()), _affected(grid.GetAllAffected())
   _log = spdlog::get("logger");
 }
 
+const UINT CountBuckets::NONE;
+
 // BruteForce Solver implementation
+template <UINT H, UINT W, UINT N>
+BruteForceSolver<H,W,N>::BruteForceSolver(SudokuGrid<H,W,N>& grid)
+: ISudokuSolver<H,W,N>(grid), _nodes(0), _budget(0)
+{
+  // Flatten the groups and affected cells into index lists once, so the
+  // search can walk them without scanning whole AllCells bitsets
+  _group_cells.resize(this->_groups.size());
+  for (UINT g = 0; g < this->_groups.size(); ++g) {
+    FORBITSIN(idx, _AT(this->_groups, g)) {
+      _AT(_group_cells, g).push_back(idx);
+      _AT(_cell_groups, idx).push_back(g);
+    }
+  }
+  for (UINT i = 0; i < N; ++i) {
+    FORBITSIN(peer, _AT(this->_affected, i)) _AT(_peers, i).push_back(peer);
+  }
+}
+
 template <UINT H, UINT W, UINT N>
 bool BruteForceSolver<H,W,N>::Solve() {
-  // Pair of state and what cells need to be solved in that state
-  typedef std_x::triple<GridState, AllCells, UINT> SolveState;
-  UINT iters = 0;
+  bool unique = false;
+  TIMELINE_SCOPE(TimelineKind::SOLVE, N, 0, &unique);
   _count = 0;
   _max = 2;
   _score = 0;
+  _nodes = 0;
+  _stopped = false;
+  this->_stats = SolveStats();
+  Initialise();
   
-  std::vector<SolveState> to_run;
-  AllCells to_solve(0);
-  for (UINT i = 0; i < N; ++i) {
-    if (!this->_grid.GetCell(i).IsFixed()) {
-      to_solve.set(i);
-      ++_score;
-    }
+  // Without restarts a single run searches the whole tree. With them, each
+  // run gets a Luby multiple of the budget and begins again from the top,
+  // until one run finishes its tree or finds the solutions it needs.
+  if (!_budget) Search(0);
+  else for (UINT run = 1; !Search(_budget * Luby(run)); ++run) {}
+  this->_stats.nodes = _nodes;
+  if (_stopped) {
+    this->_result = SolveResult::UNKNOWN;
+    return false;
   }
-  to_run.emplace_back(this->_initial, to_solve, 0);
-  
-  while (to_run.size()) {
-    SolveState s = to_run.back();
-    to_run.pop_back();
-    ++iters;
-    
-    // Check all to be solved cells have potential bits set
-    // At the same time, find the cell with the least amount of options
-    UINT best_cell = s.second.size(), cell_count = _AT(s.first,0).size();
-    bool valid = true;
-    FORBITSIN(pos, s.second) {
-      if (_AT(s.first, pos).none()) {
-        valid = false;
-        break;
+  unique = _count == 1;
+  return this->Finish(unique);
+}
+
+template <UINT H, UINT W, UINT N>
+void BruteForceSolver<H,W,N>::UseRestarts(UINT seed, UINT budget) {
+  _rng.seed(seed);
+  _budget = budget;
+}
+
+template <UINT H, UINT W, UINT N>
+bool BruteForceSolver<H,W,N>::Search(UINT limit) {
+  // Returns false if the node limit (0 for none) ran out before the tree
+  // was finished, leaving the state back at the top. Running out of the
+  // solve's limits ends the search as if the tree were finished.
+  UINT guesses = 0, nodes = 0;
+  while (true) {
+    if (!Propagate()) {
+      // Dead end, a cell or a group value has nowhere left to go
+    } else if (_cells.Empty()) {
+      // A restart can find a solution it already found in an earlier run
+      if (!_count || _state != this->_solved) {
+        ++_count;
+        this->_solved = _state;
+        _score += 100 * guesses;
+        if (_count == _max) return true;  // bail out
       }
-      if (best_cell == s.second.size()) best_cell = pos;
-      if (_AT(s.first, pos).count() < cell_count) {
-        best_cell = pos;
-        cell_count = _AT(s.first, pos).count();
+    } else if ((limit && nodes == limit) || this->_limits.Exceeded(_nodes)) {
+      // Out of this run's nodes, or of the solve's limits altogether
+      _stopped = !(limit && nodes == limit);
+      Undo(0);
+      _choices.clear();
+      _branches.clear();
+      return _stopped;
+    } else {
+      Choose(guesses);
+      ++nodes;
+      ++_nodes;
+      this->_stats.depth = std::max(this->_stats.depth, (UINT)_branches.size());
+    }
+    
+    // Undo back to the most recent branch with choices left and take one
+    bool advanced = false;
+    while (!advanced && _branches.size()) {
+      Branch& branch = _branches.back();
+      Undo(branch.trail);
+      if (branch.next < branch.end) {
+        const std::pair<UINT, UINT>& choice = _AT(_choices, branch.next);
+        ++branch.next;
+        guesses = branch.guesses;
+        Assign(choice.first, choice.second);
+        advanced = true;
+      } else {
+        TIMELINE_SPAN(TimelineKind::BRANCH, branch.started, _branches.size(),
+                      branch.end - branch.begin);
+        _choices.resize(branch.begin);
+        _branches.pop_back();
       }
     }
-    if (!valid) continue;
-    // Check if solved
-    if (best_cell == s.second.size()) {
-      ++_count;
-      this->_solved = s.first;
-      _score += 100 * s.third;
-      if (_count == _max) break;  // bail out
+    if (!advanced) return true;
+  }
+}
+
+template <UINT H, UINT W, UINT N>
+void BruteForceSolver<H,W,N>::Initialise() {
+  _state = this->_initial;
+  _trail.clear();
+  _choices.clear();
+  _branches.clear();
+  
+  _cells.Init(N, G);
+  for (UINT i = 0; i < N; ++i) {
+    if (this->_grid.GetCell(i).IsFixed()) continue;
+    _cells.Insert(i, _AT(_state, i).count());
+    ++_score;
+  }
+  
+  _places.Init(this->_groups.size() * G, G);
+  for (UINT g = 0; g < _group_cells.size(); ++g) {
+    // Only full groups have to hold every value
+    if (_AT(_group_cells, g).size() != G) continue;
+    std::array<UINT, G> counts = {0};
+    Values placed(0);
+    for (UINT idx : _AT(_group_cells, g)) {
+      if (!_cells.Contains(idx)) placed |= _AT(_state, idx);
+      else FORBITSIN(val, _AT(_state, idx)) ++_AT(counts, val);
+    }
+    for (UINT val = 0; val < G; ++val) {
+      if (!placed[val]) _places.Insert(g * G + val, _AT(counts, val));
+    }
+  }
+}
+
+template <UINT H, UINT W, UINT N>
+bool BruteForceSolver<H,W,N>::Propagate() {
+  // Place naked and hidden singles until none are left. Returns false as
+  // soon as a cell or group value runs out of options.
+  while (true) {
+    if (_cells.Lowest() == 0 || _places.Lowest() == 0) return false;
+    UINT cell = _cells.Front(1);
+    if (!_cells.IsEnd(cell)) {
+      Assign(cell, __find_first(_AT(_state, cell)));
       continue;
     }
-    
-    // Search for hidden sets smaller than current best.
-    UINT best_group = this->_groups.size(), group_count = _AT(s.first,0).size();
-    UINT group_val = _AT(s.first,0).size();
-    if (cell_count > 1) {
-      // Only perform the search if we're likely to exceed what's present
-      for (UINT g = 0; g < this->_groups.size(); ++g) {
-        AllCells group = _AT(this->_groups, g) & s.second;  // Only cells to solve
-        if (group.none()) continue;
-        // Get the counts of values can place in group
-        std::array<UINT, _AT(s.first,0).size()> counts = {0};
-        FORBITSIN(g_idx, group) {
-          FORBITSIN(i_val, _AT(s.first, g_idx)) ++counts[i_val];
-        }
-        
-        // If a val count is less than current group_count, change it
-        for (UINT i = 0; i < counts.size(); ++i) {
-          if (_AT(counts, i) < group_count && _AT(counts, i) != 0) {
-            group_count = _AT(counts, i);
-            group_val = i;
-            best_group = g;
-          }
-        }
-        if (group_count == 1) break;
+    UINT place = _places.Front(1);
+    if (_places.IsEnd(place)) return true;
+    UINT val = place % G;
+    for (UINT idx : _AT(_group_cells, place / G)) {
+      if (_cells.Contains(idx) && _AT(_state, idx)[val]) {
+        Assign(idx, val);
+        break;
       }
     }
-    
-    if (cell_count <= group_count) {
-      // Branch on all options available to cell
-      FORBITSIN(val, _AT(s.first, best_cell)) {
-        GridState newState;
-        AllCells new_tosolve(s.second);
-        UINT branch = s.third;
-        if (cell_count > 1) ++branch;
-        new_tosolve.reset(best_cell);
-        std::copy(s.first.begin(), s.first.end(), newState.begin());
-        _AT(newState, best_cell).reset();
-        _AT(newState, best_cell).set(val);
-        // Propagate the setting (should only affect cells to solve still)
-        const AllCells& a = _AT(this->_affected, best_cell);
-        FORBITSIN(a_pos, a) {
-          if (new_tosolve[a_pos]) _AT(newState, a_pos).reset(val);
-        }
-        to_run.emplace_back(newState, new_tosolve, branch);
-      }
-    } else {
-      // Branch on group_val in all posible places in group
-      AllCells group = _AT(this->_groups, best_group) & s.second;  // Only cells to solve
-      FORBITSIN(cell, group) {
-        if (!_AT(s.first, cell)[group_val]) continue;
-        GridState newState;
-        AllCells new_tosolve(s.second);
-        UINT branch = s.third;
-        if (group_count > 1) ++branch;
-        new_tosolve.reset(cell);
-        std::copy(s.first.begin(), s.first.end(), newState.begin());
-        _AT(newState, cell).reset();
-        _AT(newState, cell).set(group_val);
-        // Propagate the setting (should only affect cells to solve still)
-        const AllCells& a = _AT(this->_affected, cell);
-        FORBITSIN(a_pos, a) {
-          if (new_tosolve[a_pos]) _AT(newState, a_pos).reset(group_val);
+  }
+}
+
+template <UINT H, UINT W, UINT N>
+void BruteForceSolver<H,W,N>::Choose(UINT guesses) {
+  // Cell with the fewest options, then see if a group value has fewer places.
+  // Singles have all been propagated, so every choice here is a guess.
+  UINT cell_count = _cells.Lowest(1);
+  UINT place_count = _places.Lowest(1);
+  
+  Branch branch;
+  branch.trail = _trail.size();
+  branch.begin = branch.next = _choices.size();
+  branch.started = TIMELINE_NOW();
+  if (cell_count <= place_count) {
+    // Branch on all options available to cell
+    UINT cell = Pick(_cells, cell_count);
+    FORBITSIN(val, _AT(_state, cell)) _choices.emplace_back(cell, val);
+  } else {
+    // Branch on group value in all possible places in group
+    UINT place = Pick(_places, place_count);
+    UINT val = place % G;
+    for (UINT cell : _AT(_group_cells, place / G)) {
+      if (_cells.Contains(cell) && _AT(_state, cell)[val])
+        _choices.emplace_back(cell, val);
+    }
+  }
+  branch.end = _choices.size();
+  
+  if (_budget) {
+    // Least constraining choice first: the one whose value the fewest other
+    // cells in its groups could also take. Shuffle first to break ties.
+    auto begin = _choices.begin() + branch.begin, end = _choices.end();
+    std::shuffle(begin, end, _rng);
+    std::stable_sort(begin, end, [this](const std::pair<UINT, UINT>& a,
+                                        const std::pair<UINT, UINT>& b) {
+      return Constraining(a.first, a.second) < Constraining(b.first, b.second);
+    });
+  }
+  branch.guesses = guesses + (branch.end - branch.begin > 1 ? 1 : 0);
+  _branches.push_back(branch);
+}
+
+template <UINT H, UINT W, UINT N>
+UINT BruteForceSolver<H,W,N>::Pick(const CountBuckets& buckets, UINT count) {
+  // Deterministic search takes the front of the bucket. Randomised search
+  // samples uniformly from up to the first G items held in it.
+  UINT item = buckets.Front(count);
+  if (!_budget) return item;
+  UINT seen = 1;
+  for (UINT next = buckets.Next(item); !buckets.IsEnd(next) && seen < G;
+       next = buckets.Next(next)) {
+    if (std::uniform_int_distribution<UINT>(0, seen++)(_rng) == 0) item = next;
+  }
+  return item;
+}
+
+template <UINT H, UINT W, UINT N>
+UINT BruteForceSolver<H,W,N>::Constraining(UINT cell, UINT val) const {
+  UINT total = 0;
+  for (UINT g : _AT(_cell_groups, cell)) {
+    UINT place = g * G + val;
+    if (_places.Contains(place)) total += _places.Count(place);
+  }
+  return total;
+}
+
+template <UINT H, UINT W, UINT N>
+void BruteForceSolver<H,W,N>::Assign(UINT cell, UINT val) {
+  Values others = _AT(_state, cell);
+  others.reset(val);
+  FORBITSIN(other, others) Eliminate(cell, other);
+  
+  _cells.Erase(cell);
+  _trail.emplace_back(Change::CELL, cell);
+  for (UINT g : _AT(_cell_groups, cell)) {
+    UINT place = g * G + val;
+    if (!_places.Contains(place)) continue;
+    _places.Erase(place);
+    _trail.emplace_back(Change::PLACE, place);
+  }
+  
+  // Propagate the setting (should only affect cells to solve still)
+  for (UINT peer : _AT(_peers, cell)) {
+    if (_cells.Contains(peer) && _AT(_state, peer)[val]) Eliminate(peer, val);
+  }
+}
+
+template <UINT H, UINT W, UINT N>
+void BruteForceSolver<H,W,N>::Eliminate(UINT cell, UINT val) {
+  _AT(_state, cell).reset(val);
+  _trail.emplace_back(Change::CANDIDATE, cell * G + val);
+  _cells.Move(cell, _cells.Count(cell) - 1);
+  for (UINT g : _AT(_cell_groups, cell)) {
+    UINT place = g * G + val;
+    if (_places.Contains(place)) _places.Move(place, _places.Count(place) - 1);
+  }
+}
+
+template <UINT H, UINT W, UINT N>
+void BruteForceSolver<H,W,N>::Undo(UINT trail) {
+  // Reverse changes in the opposite order they were made, so every bucket
+  // an item returns to is the one it was taken from
+  while (_trail.size() > trail) {
+    const std::pair<Change, UINT>& change = _trail.back();
+    switch (change.first) {
+      case Change::CANDIDATE: {
+        UINT cell = change.second / G, val = change.second % G;
+        _AT(_state, cell).set(val);
+        _cells.Move(cell, _cells.Count(cell) + 1);
+        for (UINT g : _AT(_cell_groups, cell)) {
+          UINT place = g * G + val;
+          if (_places.Contains(place)) _places.Move(place, _places.Count(place) + 1);
         }
-        to_run.emplace_back(newState, new_tosolve, branch);
+        break;
       }
+      case Change::CELL:
+        _cells.Insert(change.second, _cells.Count(change.second));
+        break;
+      case Change::PLACE:
+        _places.Insert(change.second, _places.Count(change.second));
+        break;
     }
+    _trail.pop_back();
   }
-  return _count == 1;
 }
 
 // Logical solver implementation
 template <UINT H, UINT W, UINT N>
-LogicalSolver<H,W,N>::LogicalSolver(SudokuGrid<H,W,N>& grid)
-: ISudokuSolver<H, W, N>(grid)
+LogicalSolver<H,W,N>::LogicalSolver(SudokuGrid<H,W,N>& grid, bool trace)
+: ISudokuSolver<H, W, N>(grid), _pending(false), _trace(trace), _stopped(false),
+_removed(0)
 {
   // Build the table of intersects
   for (UINT i = 0; i < this->_groups.size(); ++i) {
@@ -160,81 +326,136 @@ LogicalSolver<H,W,N>::LogicalSolver(SudokuGrid<H,W,N>& grid)
       _intersects.emplace_back(intersect, i, j);
     }
   }
+  Begin();
 }
 
 template <UINT H, UINT W, UINT N>
-bool LogicalSolver<H,W,N>::Solve() {
+void LogicalSolver<H,W,N>::Begin() {
   _order.clear();
   _actions.clear();
   _solve_state = std::make_pair(GridState(this->_initial), AllCells(0));
-  _action_next = 0;
+  for (Values& r : _removals) r.reset();
+  _completed.reset();
+  // Patterns are narrowed by later deductions, so they're built again
+  for (UINT val = 0; val < this->G; ++val) _AT(_patterns, val).clear();
+  _pending = false;
+  _stopped = false;
+  this->_stats = SolveStats();
   for (UINT i = 0; i < N; ++i) {
     if (!this->_grid.GetCell(i).IsFixed()) _solve_state.second.set(i);
   }
+}
 
+template <UINT H, UINT W, UINT N>
+bool LogicalSolver<H,W,N>::Solve() {
+  bool solved = false;
+  TIMELINE_SCOPE(TimelineKind::SOLVE, N, 0, &solved);
+  Begin();
   while (true) {
+    // Every round but the last adds one operation to _order
+    TIMELINE_SCOPE(TimelineKind::ROUND, _order.size());
     // Handle actions decided last round
     HandleActions();
 //    this->_grid.SetState(_solve_state.first);
 //    std::cout << this->_grid << std::endl;
     if (_solve_state.second.none()) break;
-    
-    // Search for singles
-    if (NakedSingle()) continue;
-    if (HiddenSingle()) continue;
-
-    // Search for naked and hidden n-nuples where n <= G / 2
-    bool success = false;
-    for (UINT nuple = 2; nuple <= this->G / 2; ++nuple) {
-      if (NakedNuple(nuple)) success = true;
-      if (success) break;
+    ++this->_stats.rounds;
+    // A round is a node, as is each partial pattern overlay builds
+    if (this->_limits.Exceeded(++this->_stats.nodes, true)) {
+      _stopped = true;
+      break;
     }
-    if (success) continue;
-    for (UINT nuple = 2; nuple <= this->G / 2; ++nuple) {
-      if (HiddenNuple(nuple)) success = true;
-      if (success) break;
-    }
-    if (success) continue;
-
-    if (GroupIntersection()) continue;
-    if (BugRemoval()) continue;
-    if (PatternOverlay()) continue;
+    if (Deduce()) continue;
+    if (_stopped) break;
     
     // Logic exhausted, so run brute force and exit if that fails
     if (BruteForce()) continue;
     break;
   }
   
-  return _solve_state.second.none();
+  this->_stats.techniques = (UINT)std::count_if(_order.begin(), _order.end(),
+    [](LogicOperation op) { return op != LogicOperation::BRUTE_FORCE; });
+  if (_stopped) {
+    this->_result = SolveResult::UNKNOWN;
+    return false;
+  }
+  solved = _solve_state.second.none();
+  return this->Finish(solved);
+}
+
+template <UINT H, UINT W, UINT N>
+bool LogicalSolver<H,W,N>::Next(Deduction& step) {
+  HandleActions();
+  step.operation = LogicOperation::NUM_OPERATIONS;
+  step.actions.clear();
+  if (_solve_state.second.none() || _stopped) return false;
+  bool found = Deduce();
+  // From the pending masks rather than the trace, as techniques can find
+  // the same removal more than once
+  for (UINT i = 0; i < N; ++i) {
+    FORBITSIN(val, _AT(_removals, i)) step.actions.emplace_back(Action::REMOVE, val, i);
+  }
+  FORBITSIN(i, _completed) {
+    Values left = _AT(_solve_state.first, i) & ~_AT(_removals, i);
+    step.actions.emplace_back(Action::COMPLETE, __find_first(left), i);
+  }
+  if (!found) return false;
+  ++this->_stats.rounds;
+  step.operation = _order.back();
+  return true;
+}
+
+// Techniques from the easiest, stopping at the first to find something
+template <UINT H, UINT W, UINT N>
+bool LogicalSolver<H,W,N>::Deduce() {
+  // Search for singles
+  if (NakedSingle()) return true;
+  if (HiddenSingle()) return true;
+
+  // Search for naked and hidden n-nuples where n <= G / 2
+  for (UINT nuple = 2; nuple <= this->G / 2; ++nuple) {
+    if (NakedNuple(nuple)) return true;
+  }
+  for (UINT nuple = 2; nuple <= this->G / 2; ++nuple) {
+    if (HiddenNuple(nuple)) return true;
+  }
+
+  if (GroupIntersection()) return true;
+  if (BugRemoval()) return true;
+  return PatternOverlay();
 }
 
 template <UINT H, UINT W, UINT N>
 void LogicalSolver<H,W,N>::HandleActions() {
-  while (_action_next < _actions.size()) {
-    Actionable& action = _AT(_actions, _action_next);
-    switch (action.first) {
-      case Action::REMOVE:
-        _AT(_solve_state.first, action.third).reset(action.second);
-        break;
-      case Action::COMPLETE:
-        _solve_state.second.reset(action.second);
-        break;
-    }
-//    auto gs = GetCellGroups<H,W,N>(action.second);
-//    std::cout << "Remove " << action.first + 1 << " from r" << gs.first + 1 << "c" << gs.second + 1 << std::endl;
-    ++_action_next;
+  // Duplicate removals collapse into the same mask bit, so a single
+  // AND-NOT pass applies everything found last round. The pass clears the
+  // pending flag, so what it applies is counted as it goes.
+  const bool applying = _pending;
+  uint64_t applied = 0;
+  INSTRUMENT_STATS(_instruments, _instruments.Actions(), applying, applied);
+  if (!_pending) return;
+  for (UINT i = 0; i < N; ++i) {
+    INSTRUMENT_ADD(applied, (_AT(_solve_state.first, i) & _AT(_removals, i)).count());
+    _AT(_solve_state.first, i) &= ~_AT(_removals, i);
+    _AT(_removals, i).reset();
   }
+  _solve_state.second &= ~_completed;
+  _completed.reset();
+  _pending = false;
 }
 
 template <UINT H, UINT W, UINT N>
 bool LogicalSolver<H,W,N>::NakedSingle() {
+  INSTRUMENT_TECHNIQUE(_instruments, LogicOperation::NAKED_SINGLE, _pending, _removed);
+  TIMELINE_SCOPE(TimelineKind::TECHNIQUE, (UINT)LogicOperation::NAKED_SINGLE, 0, &_pending);
+  INSTRUMENT_SCANNED(_solve_state.second.count());
   FORBITSIN(idx, _solve_state.second) {
     if (_AT(_solve_state.first, idx).count() == 1) {
       UINT val = __find_first(_AT(_solve_state.first, idx));
       SetSingleValue(val, idx);
     }
   }
-  if (_actions.size() > _action_next) {
+  if (_pending) {
     _order.push_back(LogicOperation::NAKED_SINGLE);
     return true;
   }
@@ -243,6 +464,9 @@ bool LogicalSolver<H,W,N>::NakedSingle() {
 
 template <UINT H, UINT W, UINT N>
 bool LogicalSolver<H,W,N>::HiddenSingle() {
+  INSTRUMENT_TECHNIQUE(_instruments, LogicOperation::HIDDEN_SINGLE, _pending, _removed);
+  TIMELINE_SCOPE(TimelineKind::TECHNIQUE, (UINT)LogicOperation::HIDDEN_SINGLE, 0, &_pending);
+  INSTRUMENT_SCANNED(this->_groups.size());
   for (const AllCells& group : this->_groups) {
     FORBITSIN(ga_idx, group) {
       Values options = _AT(_solve_state.first, ga_idx);
@@ -253,13 +477,13 @@ bool LogicalSolver<H,W,N>::HiddenSingle() {
       if (options.count() == 1) {
         UINT val = __find_first(options);
         FORBITSIN(remove, _AT(_solve_state.first, ga_idx)) {
-          if (remove != val) _actions.emplace_back(Action::REMOVE, remove, ga_idx);
+          if (remove != val) Remove(remove, ga_idx);
         }
       }
     }
   }
   
-  if (_actions.size() > _action_next) {
+  if (_pending) {
     _order.push_back(LogicOperation::HIDDEN_SINGLE);
     return true;
   }
@@ -268,6 +492,8 @@ bool LogicalSolver<H,W,N>::HiddenSingle() {
 
 template <UINT H, UINT W, UINT N>
 bool LogicalSolver<H,W,N>::NakedNuple(UINT nuple) {
+  INSTRUMENT_TECHNIQUE(_instruments, NupleOperation(false, nuple), _pending, _removed);
+  TIMELINE_SCOPE(TimelineKind::TECHNIQUE, (UINT)NupleOperation(false, nuple), 0, &_pending);
   for (const AllCells& group : this->_groups) {
     // Find all unsets (ie still to solve) in group
     std::vector<UINT> valids, combination, complement;
@@ -279,6 +505,7 @@ bool LogicalSolver<H,W,N>::NakedNuple(UINT nuple) {
     auto generate = MakeCombinations(valids.begin(), valids.end(), nuple);
     while (generate(std::back_inserter(combination),
                     std::back_inserter(complement))) {
+      INSTRUMENT_SCANNED(1);
       Values combo_options, comple_options, intersect;
       for (UINT idx : combination) combo_options |= _AT(_solve_state.first,idx);
       
@@ -294,7 +521,7 @@ bool LogicalSolver<H,W,N>::NakedNuple(UINT nuple) {
             intersect = _AT(_solve_state.first, idx) & combo_options;
             if (intersect.none()) continue;
             FORBITSIN(remove, intersect)
-              _actions.emplace_back(Action::REMOVE, remove, idx);
+              Remove(remove, idx);
           }
         }
       }
@@ -303,11 +530,8 @@ bool LogicalSolver<H,W,N>::NakedNuple(UINT nuple) {
     }
   }
   
-  if (_actions.size() > _action_next) {
-    if (nuple == 2) _order.push_back(LogicOperation::NAKED_PAIR);
-    if (nuple == 3) _order.push_back(LogicOperation::NAKED_TRIPLE);
-    if (nuple == 4) _order.push_back(LogicOperation::NAKED_QUAD);
-    if (nuple > 4) _order.push_back(LogicOperation::NAKED_NUPLE);
+  if (_pending) {
+    _order.push_back(NupleOperation(false, nuple));
     return true;
   }
   return false;
@@ -315,6 +539,8 @@ bool LogicalSolver<H,W,N>::NakedNuple(UINT nuple) {
 
 template <UINT H, UINT W, UINT N>
 bool LogicalSolver<H,W,N>::HiddenNuple(UINT nuple) {
+  INSTRUMENT_TECHNIQUE(_instruments, NupleOperation(true, nuple), _pending, _removed);
+  TIMELINE_SCOPE(TimelineKind::TECHNIQUE, (UINT)NupleOperation(true, nuple), 0, &_pending);
   for (const AllCells& group : this->_groups) {
     // Find all unsets (ie still to solve) in group
     std::vector<UINT> valids, combination, complement;
@@ -326,6 +552,7 @@ bool LogicalSolver<H,W,N>::HiddenNuple(UINT nuple) {
     auto generate = MakeCombinations(valids.begin(), valids.end(), nuple);
     while (generate(std::back_inserter(combination),
                     std::back_inserter(complement))) {
+      INSTRUMENT_SCANNED(1);
       
       Values combo_options, comple_options, unique;
       for (UINT idx : combination) combo_options |= _AT(_solve_state.first,idx);
@@ -339,7 +566,7 @@ bool LogicalSolver<H,W,N>::HiddenNuple(UINT nuple) {
           Values intersect = _AT(_solve_state.first, idx) & (~unique);
           if (intersect.none()) continue;
           FORBITSIN(remove, intersect)
-            _actions.emplace_back(Action::REMOVE, remove, idx);
+            Remove(remove, idx);
         }
       }
       complement.clear();
@@ -347,11 +574,8 @@ bool LogicalSolver<H,W,N>::HiddenNuple(UINT nuple) {
     }
   }
   
-  if (_actions.size() > _action_next) {
-    if (nuple == 2) _order.push_back(LogicOperation::HIDDEN_PAIR);
-    if (nuple == 3) _order.push_back(LogicOperation::HIDDEN_TRIPLE);
-    if (nuple == 4) _order.push_back(LogicOperation::HIDDEN_QUAD);
-    if (nuple > 4) _order.push_back(LogicOperation::HIDDEN_NUPLE);
+  if (_pending) {
+    _order.push_back(NupleOperation(true, nuple));
     return true;
   }
   return false;
@@ -359,12 +583,17 @@ bool LogicalSolver<H,W,N>::HiddenNuple(UINT nuple) {
 
 template <UINT H, UINT W, UINT N>
 bool LogicalSolver<H,W,N>::BruteForce() {
+  INSTRUMENT_TECHNIQUE(_instruments, LogicOperation::BRUTE_FORCE, _pending, _removed);
+  TIMELINE_SCOPE(TimelineKind::TECHNIQUE, (UINT)LogicOperation::BRUTE_FORCE, 0, &_pending);
   _order.push_back(LogicOperation::BRUTE_FORCE);
   return false;
 }
 
 template <UINT H, UINT W, UINT N>
 bool LogicalSolver<H,W,N>::GroupIntersection() {
+  INSTRUMENT_TECHNIQUE(_instruments, LogicOperation::INTERSECTION_REMOVAL, _pending, _removed);
+  TIMELINE_SCOPE(TimelineKind::TECHNIQUE, (UINT)LogicOperation::INTERSECTION_REMOVAL, 0, &_pending);
+  INSTRUMENT_SCANNED(_intersects.size());
   for (Intersection& intersect : _intersects) {
     AllCells int_cells = intersect.first & _solve_state.second;
     AllCells a_cells = _AT(this->_groups, intersect.second) & ~intersect.first;
@@ -397,7 +626,7 @@ bool LogicalSolver<H,W,N>::GroupIntersection() {
     FORBITSIN(rval_b, i_not_a) {
       FORBITSIN(ridx_b, b_cells) {
         if (_solve_state.first[ridx_b][rval_b])
-          _actions.emplace_back(Action::REMOVE, rval_b, ridx_b);
+          Remove(rval_b, ridx_b);
       }
     }
     
@@ -406,12 +635,12 @@ bool LogicalSolver<H,W,N>::GroupIntersection() {
     FORBITSIN(rval_a, i_not_b) {
       FORBITSIN(ridx_a, a_cells) {
         if (_solve_state.first[ridx_a][rval_a])
-          _actions.emplace_back(Action::REMOVE, rval_a, ridx_a);
+          Remove(rval_a, ridx_a);
       }
     }
   
   }
-  if (_actions.size() > _action_next) {
+  if (_pending) {
     _order.push_back(LogicOperation::INTERSECTION_REMOVAL);
     return true;
   }
@@ -420,6 +649,8 @@ bool LogicalSolver<H,W,N>::GroupIntersection() {
 
 template <UINT H, UINT W, UINT N>
 bool LogicalSolver<H,W,N>::PatternOverlay() {
+  INSTRUMENT_TECHNIQUE(_instruments, LogicOperation::PATTERN_OVERLAY, _pending, _removed);
+  TIMELINE_SCOPE(TimelineKind::TECHNIQUE, (UINT)LogicOperation::PATTERN_OVERLAY, 0, &_pending);
   std::array<AllCells, G> val_masks;
   for (UINT val = 0; val < G; ++val) {
     // Determine all cells that can contain val
@@ -437,6 +668,13 @@ bool LogicalSolver<H,W,N>::PatternOverlay() {
       while (partials.size()) {
         std::pair<AllCells, UINT> current = partials.back();
         partials.pop_back();
+        // Each partial pattern is a search node. Half built patterns would
+        // be wrong next time, so they go if the limits run out.
+        if (this->_limits.Exceeded(++this->_stats.nodes)) {
+          _AT(_patterns, val).clear();
+          _stopped = true;
+          return false;
+        }
         
         if (current.second == G) {
           _AT(_patterns, val).emplace_back(current.first);
@@ -464,12 +702,13 @@ bool LogicalSolver<H,W,N>::PatternOverlay() {
   for (UINT val = 0; val < G; ++val) {
     AllCells used(0);
     for (AllCells& pattern : _AT(_patterns, val)) used |= pattern;
+    INSTRUMENT_SCANNED(_AT(_patterns, val).size());
     AllCells not_used = _AT(val_masks, val) & ~used;
     if (not_used.none()) continue;
-    FORBITSIN(cell, not_used) _actions.emplace_back(Action::REMOVE, val, cell);
+    FORBITSIN(cell, not_used) Remove(val, cell);
   }
   
-  if (_actions.size() > _action_next) {
+  if (_pending) {
     _order.push_back(LogicOperation::PATTERN_OVERLAY);
     return true;
   }
@@ -484,6 +723,10 @@ bool LogicalSolver<H,W,N>::PatternOverlay() {
     while (partials.size()) {
       std::pair<AllCells, UINT> current = partials.back();
       partials.pop_back();
+      if (this->_limits.Exceeded(++this->_stats.nodes)) {
+        _stopped = true;
+        return false;
+      }
       if (current.first.none()) continue;
       
       if (current.second == G) {
@@ -524,9 +767,9 @@ bool LogicalSolver<H,W,N>::PatternOverlay() {
     for (AllCells& pattern : _AT(_patterns, val)) used |= pattern;
     AllCells not_used = _AT(val_masks, val) & ~used;
     if (not_used.none()) continue;
-    FORBITSIN(cell, not_used) _actions.emplace_back(Action::REMOVE, val, cell);
+    FORBITSIN(cell, not_used) Remove(val, cell);
   }
-  if (_actions.size() > _action_next) {
+  if (_pending) {
     _order.push_back(LogicOperation::PATTERN_OVERLAY);
     return true;
   }
@@ -535,6 +778,9 @@ bool LogicalSolver<H,W,N>::PatternOverlay() {
 
 template <UINT H, UINT W, UINT N>
 bool LogicalSolver<H,W,N>::BugRemoval() {
+  INSTRUMENT_TECHNIQUE(_instruments, LogicOperation::BUG_REMOVAL, _pending, _removed);
+  TIMELINE_SCOPE(TimelineKind::TECHNIQUE, (UINT)LogicOperation::BUG_REMOVAL, 0, &_pending);
+  INSTRUMENT_SCANNED(_solve_state.second.count());
   bool seen_three = false;
   UINT three_idx = 0;
   Values odds(0);
@@ -554,10 +800,10 @@ bool LogicalSolver<H,W,N>::BugRemoval() {
   if (!seen_three) return false;
   
   FORBITSIN(idx, _AT(_solve_state.first, three_idx)) {
-    if (!odds[idx]) _actions.emplace_back(Action::REMOVE, idx, three_idx);
+    if (!odds[idx]) Remove(idx, three_idx);
   }
   
-  if (_actions.size() > _action_next) {
+  if (_pending) {
     _order.push_back(LogicOperation::BUG_REMOVAL);
     return true;
   }
@@ -567,33 +813,12 @@ bool LogicalSolver<H,W,N>::BugRemoval() {
 template <UINT H, UINT W, UINT N>
 void LogicalSolver<H,W,N>::SetSingleValue(UINT val, UINT idx) {
   // Adds actions to remove val from all cells affected by idx
-#ifdef DEBUG
-  std::stringstream ss;
-  bool done_first = false;
-#endif
+  TIMELINE_EVENT(TimelineKind::PLACE, val, idx);
   FORBITSIN(affect, _AT(this->_affected, idx)) {
-    if (_solve_state.first[affect][val]) {
-      _actions.emplace_back(Action::REMOVE, val, affect);
-#ifdef DEBUG
-      auto rcb = GetCellGroups<H,W,N>(affect);
-      if (!done_first) {
-        ss << "r" << rcb.first+1 << "c" << rcb.second+1;
-        done_first = true;
-      } else ss << ", r" << rcb.first+1 << "c" << rcb.second+1;
-#endif
-    }
+    if (_solve_state.first[affect][val]) Remove(val, affect);
   }
   // Complete the cell
-  _actions.emplace_back(Action::COMPLETE, idx, idx);
-#ifdef DEBUG
-  auto rcb = GetCellGroups<H,W,N>(idx);
-  if (ss.str().size())
-    this->_log->debug("[NAKED SINGLE] R{}C{} can only be {}. Removes {} from {}.",
-                      rcb.first+1, rcb.second+1, val+1, val+1, ss.str());
-  else
-    this->_log->debug("[NAKED SINGLE] R{}C{} can only be {}. No removals made.",
-                      rcb.first+1, rcb.second+1, val+1);
-#endif
+  Complete(val, idx);
 }
 
 // explicit init
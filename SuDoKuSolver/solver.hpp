@@ -12,38 +12,53 @@
 #include "defines.hpp"
 
 #include <array>
+#include <atomic>
+#include <chrono>
 #include <list>
+#include <random>
 #include <vector>
 
 #include "spdlog/spdlog.h"
 
+#include "instrument.hpp"
+#include "operations.hpp"
+#include "timeline.hpp"
 #include "utility.hpp"
 
-enum class LogicOperation {
-  NAKED_SINGLE,
-  HIDDEN_SINGLE,
-  NAKED_PAIR,
-  HIDDEN_PAIR,
-  NAKED_TRIPLE,
-  HIDDEN_TRIPLE,
-  NAKED_QUAD,
-  HIDDEN_QUAD,
-  NAKED_NUPLE,        // For larger grids
-  HIDDEN_NUPLE,
-  INTERSECTION_REMOVAL,
-  BUG_REMOVAL,
-  PATTERN_OVERLAY,
-  BRUTE_FORCE,         // Last resort
-  NUM_OPERATIONS
+template<UINT H, UINT W, UINT N>
+class SudokuGrid;
+
+// How a solve ended. UNKNOWN when its limits ran out before an answer.
+enum class SolveResult {
+  SOLVED,
+  UNSOLVED,
+  UNKNOWN,
 };
 
-enum class Action {
-  REMOVE,
-  COMPLETE,
+// Optional bounds on a solve, checked at search nodes and logic rounds
+struct SolveLimits {
+  typedef std::chrono::steady_clock Clock;
+  Clock::time_point deadline = Clock::time_point::max();
+  uint64_t nodes = 0;                         // 0 for no limit
+  const std::atomic<bool>* cancel = nullptr;  // set from another thread
+  
+  // Whether a solve that has used this many nodes should stop. Reading the
+  // clock costs more than a node, so it's only read every 64 unless forced.
+  inline bool Exceeded(uint64_t used, bool force = false) const {
+    if (nodes && used >= nodes) return true;
+    if (cancel && cancel->load(std::memory_order_relaxed)) return true;
+    return (force || (used & 63) == 0) && deadline != Clock::time_point::max() &&
+      Clock::now() >= deadline;
+  }
 };
 
-template<UINT H, UINT W, UINT N>
-class SudokuGrid;
+// What a solve got through, kept when it stops early
+struct SolveStats {
+  uint64_t nodes = 0;
+  UINT depth = 0;       // deepest search level
+  UINT rounds = 0;      // logical solve rounds
+  UINT techniques = 0;  // techniques that made progress
+};
 
 template <UINT H, UINT W, UINT N>
 class ISudokuSolver {
@@ -62,6 +77,9 @@ protected:
   const std::array<AllCells, N> _affected;
   bool _quiet;
   std::shared_ptr<spdlog::logger> _log;
+  SolveLimits _limits;
+  SolveResult _result = SolveResult::UNSOLVED;
+  SolveStats _stats;
   
 private:
   ISudokuSolver() = default;
@@ -70,6 +88,68 @@ public:
   ISudokuSolver(SudokuGrid<H,W,N>&);
   virtual bool Solve() = 0;  // T/F if solved
   const GridState& GetSolvedState() { return _solved; }
+  // Bounds for later solves. BruteForceSolver, LogicalSolver, BandSolver
+  // and LaneSolver stop when these run out, returning false with an UNKNOWN
+  // result; other engines always run to an answer.
+  void SetLimits(const SolveLimits& limits) { _limits = limits; }
+  SolveResult GetResult() const { return _result; }
+  const SolveStats& GetStats() const { return _stats; }
+  
+protected:
+  inline bool Finish(bool solved) {
+    _result = solved ? SolveResult::SOLVED : SolveResult::UNSOLVED;
+    return solved;
+  }
+};
+
+// Items kept in intrusive doubly linked lists, one per count. Moving an
+// item to a neighbouring count and finding the lowest non-empty count are
+// both cheap, so the search never has to scan for its best choice.
+class CountBuckets {
+  static const UINT NONE = ~UINT(0);
+  std::vector<UINT> _next, _prev, _count, _head;
+  std::vector<bool> _in;
+  UINT _size;
+  
+public:
+  void Init(UINT items, UINT max_count) {
+    _next.assign(items, NONE);
+    _prev.assign(items, NONE);
+    _count.assign(items, 0);
+    _in.assign(items, false);
+    _head.assign(max_count + 1, NONE);
+    _size = 0;
+  }
+  inline void Insert(UINT item, UINT count) {
+    _count[item] = count;
+    _prev[item] = NONE;
+    _next[item] = _head[count];
+    if (_next[item] != NONE) _prev[_next[item]] = item;
+    _head[count] = item;
+    _in[item] = true;
+    ++_size;
+  }
+  inline void Erase(UINT item) {
+    if (_prev[item] != NONE) _next[_prev[item]] = _next[item];
+    else _head[_count[item]] = _next[item];
+    if (_next[item] != NONE) _prev[_next[item]] = _prev[item];
+    _in[item] = false;
+    --_size;
+  }
+  inline void Move(UINT item, UINT count) { Erase(item); Insert(item, count); }
+  inline bool Contains(UINT item) const { return _in[item]; }
+  inline bool Empty() const { return _size == 0; }
+  // Count an item was last held at, kept while it is erased
+  inline UINT Count(UINT item) const { return _count[item]; }
+  // First item with the given count, or NONE
+  inline UINT Front(UINT count) const { return _head[count]; }
+  inline UINT Next(UINT item) const { return _next[item]; }
+  inline bool IsEnd(UINT item) const { return item == NONE; }
+  // Lowest count from the one given holding any items, or one past the max
+  inline UINT Lowest(UINT from = 0) const {
+    while (from < _head.size() && _head[from] == NONE) ++from;
+    return from;
+  }
 };
 
 template <UINT H, UINT W = H, UINT N = H * H * W * W>
@@ -81,12 +161,45 @@ public:
   typedef std::array<Values, N> GridState;
   
 public:
-  using ISudokuSolver<H,W,N>::ISudokuSolver;
+  BruteForceSolver(SudokuGrid<H,W,N>&);
   virtual bool Solve();
   inline UINT GetScore() { return _score; }
+  inline UINT GetNodes() { return _nodes; }
+  // Break ties at random, try least constraining choices first and restart
+  // when a run uses up a Luby multiple of the node budget. Seeded so runs
+  // can be reproduced; a budget of 0 turns it back off.
+  void UseRestarts(UINT seed, UINT budget = 64);
   
 private:
-  UINT _max, _count, _score;
+  // Candidate removed (cell * G + value), cell solved, group value placed
+  enum class Change { CANDIDATE, CELL, PLACE };
+  // Trail position, range of choices and next to try, guesses made to here,
+  // and when it was made for the timeline
+  struct Branch { UINT trail, begin, next, end, guesses; uint64_t started; };
+  
+  UINT _max, _count, _score, _nodes, _budget;
+  bool _stopped;  // limits ran out
+  std::mt19937 _rng;
+  GridState _state;
+  // Unsolved cells by number of candidates, unplaced (group * G + value)
+  // pairs by number of cells that could take them
+  CountBuckets _cells, _places;
+  std::array<std::vector<UINT>, N> _cell_groups, _peers;
+  std::vector<std::vector<UINT>> _group_cells;
+  std::vector<std::pair<Change, UINT>> _trail;
+  std::vector<std::pair<UINT, UINT>> _choices;
+  std::vector<Branch> _branches;
+  
+private:
+  void Initialise();
+  bool Search(UINT);
+  bool Propagate();
+  void Choose(UINT);
+  UINT Pick(const CountBuckets&, UINT);
+  UINT Constraining(UINT, UINT) const;
+  void Assign(UINT, UINT);
+  void Eliminate(UINT, UINT);
+  void Undo(UINT);
 };
 
 
@@ -102,11 +215,30 @@ public:
   typedef std::pair<GridState, AllCells> SolveState;
   typedef std_x::triple<const AllCells, UINT, UINT> Intersection;
   typedef std::list<AllCells> Patterns;
+  // One deduction: the technique that made it, and the values it removed
+  // from cells and the cells it completed with a value
+  struct Deduction {
+    LogicOperation operation;
+    std::vector<Actionable> actions;
+  };
   
 public:
-  LogicalSolver(SudokuGrid<H,W,N>&);
+  LogicalSolver(SudokuGrid<H,W,N>&, bool trace = false);
   virtual bool Solve();
+  // Hints, one deduction at a time from the clues. Each Next applies the
+  // last deduction and runs techniques from the easiest only until one
+  // finds something. False once solved, or when only brute force is left.
+  void Begin();
+  bool Next(Deduction&);
+  // Candidates after the deductions applied so far
+  const GridState& CurrentState() const { return _solve_state.first; }
   const std::vector<LogicOperation>& LogicalOperations() { return _order; }
+  // Step by step history of actions. Only recorded when tracing.
+  const std::vector<Actionable>& Actions() { return _actions; }
+  // Per technique counts and timings. Only recorded when built with
+  // USE_INSTRUMENTATION.
+  const Instruments& GetInstruments() const { return _instruments; }
+  void SetPerfCounters(const PerfCounters* perf) { _instruments.SetPerfCounters(perf); }
   
 private:
   SolveState _solve_state;
@@ -114,11 +246,17 @@ private:
   std::vector<Actionable> _actions;
   std::vector<Intersection> _intersects;
   std::array<Patterns, G> _patterns;
-  UINT _action_next;
+  // Pending eliminations per cell and cells to complete, applied in bulk
+  GridState _removals;
+  AllCells _completed;
+  bool _pending, _trace, _stopped;
+  Instruments _instruments;
+  uint64_t _removed;
   
 private:
   // Logic
   void HandleActions();
+  bool Deduce();
   bool NakedSingle();
   bool HiddenSingle();
   bool NakedNuple(UINT);
@@ -130,8 +268,19 @@ private:
   
   // Useful utilities
   void SetSingleValue(UINT, UINT);
-  
-  
+  inline void Remove(UINT val, UINT idx) {
+    // Counted once per candidate, however many techniques find it
+    if (!_AT(_removals, idx)[val]) INSTRUMENT_COUNT(_removed);
+    _AT(_removals, idx).set(val);
+    _pending = true;
+    TIMELINE_EVENT(TimelineKind::REMOVE, val, idx);
+    if (_trace) _actions.emplace_back(Action::REMOVE, val, idx);
+  }
+  inline void Complete(UINT val, UINT idx) {
+    _completed.set(idx);
+    _pending = true;
+    if (_trace) _actions.emplace_back(Action::COMPLETE, val, idx);
+  }
 };
 
 
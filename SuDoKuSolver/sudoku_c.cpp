@@ -0,0 +1,237 @@
+//
+//  sudoku_c.cpp
+//  SuDoKuSolver
+//
+//  Copyright © 2018 Hermes Productions. All rights reserved.
+//
+
+#include "sudoku_c.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "dispatch.hpp"
+#include "validator.hpp"
+
+namespace {
+  // One call's puzzles, claimed STEP at a time by whichever thread is free
+  struct Batch {
+    UINT size;
+    const char* puzzles;
+    size_t n;
+    char* solutions;
+    sudoku_result_t* results;
+    std::atomic<size_t> next;
+    std::atomic<int64_t> solved;
+    std::atomic<bool> failed;   // a thread couldn't finish its share
+  };
+  const size_t STEP = 64;
+
+  int32_t Status(ParseError e) {
+    switch (e) {
+      case ParseError::NONE: return SUDOKU_SOLVED;
+      case ParseError::TOO_SHORT:
+      case ParseError::TOO_LONG: return SUDOKU_ERROR_LENGTH;
+      case ParseError::BAD_CHARACTER: return SUDOKU_ERROR_CHARACTER;
+      case ParseError::VALUE_TOO_LARGE: return SUDOKU_ERROR_VALUE;
+      case ParseError::CONFLICT: return SUDOKU_ERROR_CONFLICT;
+    }
+    return SUDOKU_ERROR_CHARACTER;
+  }
+
+  // Never throws, as it also runs on pool threads
+  void Work(SizeDispatcher& dispatcher, DispatchResult& dispatched, Batch& batch) try {
+    const UINT cells = GRID_SIZES[batch.size].n;
+    int64_t solved = 0;
+    size_t first;
+    while (!batch.failed && (first = batch.next.fetch_add(STEP)) < batch.n) {
+      for (size_t i = first; i < std::min(first + STEP, batch.n); ++i) {
+        std::string_view puzzle(batch.puzzles + i * cells, cells);
+        char* solution = batch.solutions + i * cells;
+        sudoku_result_t& result = batch.results[i];
+        result.clues = cells - (uint32_t)std::count(puzzle.begin(), puzzle.end(), '.');
+        result.score = 0;
+        result.position = 0;
+        bool read = dispatcher.Solve(batch.size, puzzle, dispatched);
+        if (!read || dispatched.parsed.error != ParseError::NONE) {
+          result.status = Status(dispatched.parsed.error);
+          result.position = (uint32_t)dispatched.parsed.position;
+        } else {
+          result.status = dispatched.result == SolveResult::SOLVED ? SUDOKU_SOLVED
+                                                                   : SUDOKU_UNSOLVED;
+          result.score = (uint32_t)dispatched.score;
+        }
+        if (result.status == SUDOKU_SOLVED) {
+          std::memcpy(solution, dispatched.solution.data(), cells);
+          ++solved;
+        } else {
+          std::memcpy(solution, puzzle.data(), cells);
+        }
+      }
+    }
+    batch.solved += solved;
+  } catch (...) {
+    batch.failed = true;
+  }
+
+  // Threads kept between calls, each with its own warm dispatcher. The
+  // calling thread works too, so a batch on n threads wakes n - 1 of them.
+  class WorkerPool {
+  public:
+    ~WorkerPool() {
+      {
+        std::lock_guard<std::mutex> lock(_state);
+        _stopping = true;
+      }
+      _wake.notify_all();
+      for (auto& w : _workers) {
+        if (w->thread.joinable()) w->thread.join();
+      }
+    }
+
+    void Run(Batch& batch, UINT threads, SizeDispatcher& dispatcher,
+             DispatchResult& dispatched) {
+      std::lock_guard<std::mutex> turn(_turn);
+      // A worker is only kept once its thread has started, so a failed
+      // start can't leave the batch waiting on it
+      _workers.reserve(threads);
+      while (_workers.size() + 1 < threads) {
+        std::unique_ptr<Worker> w(new Worker());
+        w->thread = std::thread(&WorkerPool::Loop, this, w.get(), _workers.size(),
+                                _generation);
+        _workers.push_back(std::move(w));
+      }
+      {
+        std::lock_guard<std::mutex> lock(_state);
+        _batch = &batch;
+        _active = threads - 1;
+        _running = _active;
+        ++_generation;
+      }
+      _wake.notify_all();
+      Work(dispatcher, dispatched, batch);
+      std::unique_lock<std::mutex> lock(_state);
+      _done.wait(lock, [this] { return _running == 0; });
+      _batch = nullptr;
+    }
+
+  private:
+    struct Worker {
+      std::thread thread;
+      SizeDispatcher dispatcher;
+      DispatchResult dispatched;
+    };
+
+    // Starts from the generation it was made in, so it can't miss the
+    // batch it was made for
+    void Loop(Worker* w, UINT index, uint64_t seen) {
+      std::unique_lock<std::mutex> lock(_state);
+      while (true) {
+        _wake.wait(lock, [&] { return _stopping || _generation != seen; });
+        if (_stopping) return;
+        seen = _generation;
+        if (index >= _active) continue;
+        Batch& batch = *_batch;
+        lock.unlock();
+        Work(w->dispatcher, w->dispatched, batch);
+        lock.lock();
+        if (--_running == 0) _done.notify_one();
+      }
+    }
+
+    std::vector<std::unique_ptr<Worker>> _workers;
+    std::mutex _turn, _state;
+    std::condition_variable _wake, _done;
+    Batch* _batch = nullptr;
+    UINT _active = 0, _running = 0;
+    uint64_t _generation = 0;
+    bool _stopping = false;
+  };
+}
+
+extern "C" {
+
+int sudoku_num_sizes(void) {
+  return (int)NUM_GRID_SIZES;
+}
+
+int sudoku_size_info(int size, uint32_t* h, uint32_t* w, uint32_t* cells) {
+  if (size < 0 || (UINT)size >= NUM_GRID_SIZES) return SUDOKU_ERROR_SIZE;
+  if (h) *h = (uint32_t)GRID_SIZES[size].h;
+  if (w) *w = (uint32_t)GRID_SIZES[size].w;
+  if (cells) *cells = (uint32_t)GRID_SIZES[size].n;
+  return 0;
+}
+
+int sudoku_find_size(uint32_t h, uint32_t w) {
+  for (UINT i = 0; i < NUM_GRID_SIZES; ++i) {
+    if (GRID_SIZES[i].h == h && GRID_SIZES[i].w == w) return (int)i;
+  }
+  return SUDOKU_ERROR_SIZE;
+}
+
+int64_t sudoku_solve_batch(int size, const char* puzzles, size_t n, char* solutions,
+                           sudoku_result_t* results, unsigned threads) try {
+  if (size < 0 || (UINT)size >= NUM_GRID_SIZES) return SUDOKU_ERROR_SIZE;
+  if (!n) return 0;
+  if (!puzzles || !solutions || !results) return SUDOKU_ERROR_ARGUMENT;
+  Batch batch;
+  batch.size = (UINT)size;
+  batch.puzzles = puzzles;
+  batch.n = n;
+  batch.solutions = solutions;
+  batch.results = results;
+  batch.next = 0;
+  batch.solved = 0;
+  batch.failed = false;
+
+  // Sizes are set up on each thread's first puzzle of them, then reused
+  thread_local SizeDispatcher dispatcher;
+  thread_local DispatchResult dispatched;
+  UINT workers = std::min((size_t)std::max(threads, 1u), (n + STEP - 1) / STEP);
+  if (workers <= 1) {
+    Work(dispatcher, dispatched, batch);
+  } else {
+    static WorkerPool pool;
+    pool.Run(batch, workers, dispatcher, dispatched);
+  }
+  if (batch.failed) return SUDOKU_ERROR_INTERNAL;
+  return batch.solved.load();
+} catch (...) {
+  return SUDOKU_ERROR_INTERNAL;
+}
+
+int64_t sudoku_validate_batch(int size, const char* solutions, const char* puzzles, size_t n,
+                              sudoku_result_t* results) try {
+  if (size < 0 || (UINT)size >= NUM_GRID_SIZES) return SUDOKU_ERROR_SIZE;
+  if (!n) return 0;
+  if (!solutions || !results) return SUDOKU_ERROR_ARGUMENT;
+  thread_local std::unique_ptr<SolutionValidator> validators[NUM_GRID_SIZES];
+  thread_local std::vector<SolutionCheck> checks;
+  if (!validators[size]) validators[size].reset(new SolutionValidator((UINT)size));
+  checks.resize(n);
+  size_t valid = validators[size]->Validate(solutions, puzzles, n, checks.data());
+  for (size_t i = 0; i < n; ++i) {
+    sudoku_result_t& result = results[i];
+    switch (checks[i].error) {
+      case SolutionError::NONE: result.status = SUDOKU_SOLVED; break;
+      case SolutionError::BAD_CHARACTER: result.status = SUDOKU_ERROR_CHARACTER; break;
+      case SolutionError::CLUE_CHANGED: result.status = SUDOKU_ERROR_CLUE; break;
+      case SolutionError::CONFLICT: result.status = SUDOKU_ERROR_CONFLICT; break;
+    }
+    result.clues = 0;
+    result.score = 0;
+    result.position = (uint32_t)checks[i].position;
+  }
+  return (int64_t)valid;
+} catch (...) {
+  return SUDOKU_ERROR_INTERNAL;
+}
+
+}
@@ -0,0 +1,82 @@
+/*
+ *  sudoku_c.h
+ *  SuDoKuSolver
+ *
+ *  Copyright © 2018 Hermes Productions. All rights reserved.
+ */
+
+#ifndef SUDOKUSOLVER_SUDOKU_C_H
+#define SUDOKUSOLVER_SUDOKU_C_H
+
+/*
+ * C interface for embedding the solver, built into a shared library with
+ * the rest of the sources (everything but main.cpp). Nothing is allocated
+ * for the caller: puzzles are read from, and solutions and results written
+ * to, buffers the caller owns. Errors are status codes, never exceptions.
+ *
+ * Puzzles and solutions are strings of cells with no terminators, packed
+ * back to back: "." for a blank, then 1-9, 0 for 10, A-Z and a-z.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum sudoku_status {
+  SUDOKU_SOLVED = 0,            /* exactly one solution, written out */
+  SUDOKU_UNSOLVED = 1,          /* no solution, or more than one */
+  SUDOKU_ERROR_SIZE = -1,       /* size isn't one sudoku_size_info gives */
+  SUDOKU_ERROR_ARGUMENT = -2,   /* a null buffer */
+  SUDOKU_ERROR_LENGTH = -3,
+  SUDOKU_ERROR_CHARACTER = -4,
+  SUDOKU_ERROR_VALUE = -5,      /* a value larger than the size allows */
+  SUDOKU_ERROR_CONFLICT = -6,   /* a clue repeated in a row, column or block */
+  SUDOKU_ERROR_CLUE = -7,       /* a solution not keeping its puzzle's clue */
+  SUDOKU_ERROR_INTERNAL = -8,   /* out of memory or threads, for a whole batch */
+};
+
+typedef struct sudoku_result {
+  int32_t status;       /* sudoku_status */
+  uint32_t clues;
+  uint32_t score;       /* brute force effort, as SudokuGrid::GetScore */
+  uint32_t position;    /* offset into the puzzle of an error */
+} sudoku_result_t;
+
+/* Number of supported sizes, indexed from 0 */
+int sudoku_num_sizes(void);
+/* Block height and width and number of cells of a size */
+int sudoku_size_info(int size, uint32_t* h, uint32_t* w, uint32_t* cells);
+/* Size index for blocks h by w, or SUDOKU_ERROR_SIZE */
+int sudoku_find_size(uint32_t h, uint32_t w);
+
+/*
+ * Solves n puzzles of one size. puzzles and solutions hold n * cells
+ * characters and results n entries. Solutions of unsolved puzzles are left
+ * as the puzzle. Up to threads threads are used, from a pool kept between
+ * calls; 0 or 1 solves on the calling thread. Calls asking for more than
+ * one thread take turns with each other. Returns the number solved, or an
+ * error for the whole batch.
+ */
+int64_t sudoku_solve_batch(int size, const char* puzzles, size_t n, char* solutions,
+                           sudoku_result_t* results, unsigned threads);
+
+/*
+ * Checks n completed grids of one size, packed as above, against their
+ * rows, columns and blocks and, unless puzzles is null, the clues of the
+ * puzzles they were for. A valid grid's status is SUDOKU_SOLVED, others
+ * SUDOKU_ERROR_CHARACTER or SUDOKU_ERROR_CLUE with the cell in position,
+ * or SUDOKU_ERROR_CONFLICT with the group: rows, then columns, then
+ * blocks. Clues and score are 0. Runs on the calling thread. Returns the
+ * number valid, or an error for the whole batch.
+ */
+int64_t sudoku_validate_batch(int size, const char* solutions, const char* puzzles, size_t n,
+                              sudoku_result_t* results);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SUDOKUSOLVER_SUDOKU_C_H */
@@ -0,0 +1,122 @@
+//
+//  timeline.cpp
+//  SuDoKuSolver
+//
+//  Copyright © 2018 Hermes Productions. All rights reserved.
+//
+
+#include "timeline.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "operations.hpp"
+
+namespace {
+  struct Buffer {
+    std::vector<TimelineEvent> events;
+    uint64_t next;   // total ever recorded, wraps in events
+    UINT thread;
+  };
+
+  // Buffers outlive their threads so they can be written at the end
+  std::mutex buffers_mutex;
+  std::vector<std::unique_ptr<Buffer>> buffers;
+  UINT capacity = 1 << 16;
+  thread_local Buffer* local = nullptr;
+
+  Buffer* LocalBuffer() {
+    if (local) return local;
+    std::lock_guard<std::mutex> lock(buffers_mutex);
+    buffers.emplace_back(new Buffer());
+    local = buffers.back().get();
+    local->events.resize(capacity);
+    local->next = 0;
+    local->thread = (UINT)buffers.size();
+    return local;
+  }
+}
+
+std::atomic<bool> Timeline::_enabled(false);
+
+void Timeline::Enable(UINT events) {
+  {
+    std::lock_guard<std::mutex> lock(buffers_mutex);
+    capacity = 1;
+    while (capacity < events) capacity <<= 1;
+  }
+  _enabled.store(true, std::memory_order_relaxed);
+}
+
+void Timeline::Record(TimelineKind kind, uint64_t start, uint64_t duration, UINT a, UINT b) {
+  Buffer* buffer = LocalBuffer();
+  TimelineEvent& e = buffer->events[buffer->next++ & (buffer->events.size() - 1)];
+  e.start = start;
+  e.duration = duration;
+  e.kind = kind;
+  e.a = (uint32_t)a;
+  e.b = (uint32_t)b;
+}
+
+void Timeline::Clear() {
+  std::lock_guard<std::mutex> lock(buffers_mutex);
+  for (auto& buffer : buffers) buffer->next = 0;
+}
+
+std::ostream& Timeline::WriteChromeTrace(std::ostream& s) {
+  std::lock_guard<std::mutex> lock(buffers_mutex);
+  // Timestamps are in microseconds, relative to the first event kept
+  uint64_t origin = UINT64_MAX;
+  for (auto& buffer : buffers) {
+    uint64_t size = buffer->events.size();
+    uint64_t first = buffer->next > size ? buffer->next - size : 0;
+    for (uint64_t i = first; i < buffer->next; ++i) {
+      origin = std::min(origin, buffer->events[i & (size - 1)].start);
+    }
+  }
+
+  s << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+  bool first_event = true;
+  for (auto& buffer : buffers) {
+    uint64_t size = buffer->events.size();
+    uint64_t first = buffer->next > size ? buffer->next - size : 0;
+    for (uint64_t i = first; i < buffer->next; ++i) {
+      const TimelineEvent& e = buffer->events[i & (size - 1)];
+      s << (first_event ? "\n" : ",\n") << "{\"pid\": 1, \"tid\": " << buffer->thread
+      << ", \"ts\": " << (e.start - origin) / 1000.0;
+      first_event = false;
+      switch (e.kind) {
+        case TimelineKind::SOLVE:
+          s << ", \"ph\": \"X\", \"dur\": " << e.duration / 1000.0
+          << ", \"cat\": \"solver\", \"name\": \"solve\", \"args\": {\"cells\": "
+          << e.a << ", \"solved\": " << e.b << "}}";
+          break;
+        case TimelineKind::ROUND:
+          s << ", \"ph\": \"X\", \"dur\": " << e.duration / 1000.0
+          << ", \"cat\": \"solver\", \"name\": \"round\", \"args\": {\"round\": "
+          << e.a << "}}";
+          break;
+        case TimelineKind::TECHNIQUE:
+          s << ", \"ph\": \"X\", \"dur\": " << e.duration / 1000.0
+          << ", \"cat\": \"technique\", \"name\": \""
+          << OperationName((LogicOperation)std::min(e.a, (uint32_t)NUM_OPERATIONS))
+          << "\", \"args\": {\"success\": " << e.b << "}}";
+          break;
+        case TimelineKind::BRANCH:
+          s << ", \"ph\": \"X\", \"dur\": " << e.duration / 1000.0
+          << ", \"cat\": \"brute_force\", \"name\": \"branch\", \"args\": {\"depth\": "
+          << e.a << ", \"choices\": " << e.b << "}}";
+          break;
+        case TimelineKind::PLACE:
+        case TimelineKind::REMOVE:
+          s << ", \"ph\": \"i\", \"s\": \"t\", \"cat\": \"action\", \"name\": \""
+          << (e.kind == TimelineKind::PLACE ? "place" : "remove")
+          << "\", \"args\": {\"value\": " << e.a + 1 << ", \"cell\": " << e.b << "}}";
+          break;
+      }
+    }
+  }
+  return s << "\n]}" << std::endl;
+}
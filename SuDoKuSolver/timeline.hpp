@@ -0,0 +1,92 @@
+//
+//  timeline.hpp
+//  SuDoKuSolver
+//
+//  Copyright © 2018 Hermes Productions. All rights reserved.
+//
+
+#ifndef SUDOKUSOLVER_TIMELINE_HPP
+#define SUDOKUSOLVER_TIMELINE_HPP
+
+#include "defines.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+enum class TimelineKind : uint32_t {
+  SOLVE,      // a: cells to solve, b: solved
+  ROUND,      // a: round of the logical solve loop
+  TECHNIQUE,  // a: LogicOperation, b: found something
+  BRANCH,     // a: depth, b: choices, over one brute force subtree
+  PLACE,      // a: value, b: cell, instant
+  REMOVE,     // a: value, b: cell, instant
+};
+
+// What happened when, kept raw and only formatted when written out
+struct TimelineEvent {
+  uint64_t start, duration;
+  TimelineKind kind;
+  uint32_t a, b;
+};
+
+// Records solver events into a ring buffer per thread, keeping the most
+// recent ones, and writes them in the Chrome trace event format that
+// Perfetto and chrome://tracing load. Recording costs a flag check while
+// disabled, and nothing at all unless built with USE_TIMELINE.
+class Timeline {
+public:
+  // Buffers made after this hold the given number of events, rounded up
+  // to a power of two
+  static void Enable(UINT capacity = 1 << 16);
+  static void Disable() { _enabled.store(false, std::memory_order_relaxed); }
+  static inline bool Enabled() { return _enabled.load(std::memory_order_relaxed); }
+  static inline uint64_t Now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>
+      (std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+  static void Record(TimelineKind, uint64_t start, uint64_t duration, UINT a, UINT b);
+  // Every thread's events. Threads should have stopped recording.
+  static std::ostream& WriteChromeTrace(std::ostream&);
+  static void Clear();
+
+private:
+  static std::atomic<bool> _enabled;
+};
+
+// Records a span over its scope. The second payload can be read at the end
+// from a flag, such as whether a technique found anything.
+class TimelineScope {
+  TimelineKind _kind;
+  uint32_t _a, _b;
+  const bool* _flag;
+  uint64_t _start;
+
+public:
+  TimelineScope(TimelineKind kind, UINT a, UINT b = 0, const bool* flag = nullptr)
+  : _kind(kind), _a((uint32_t)a), _b((uint32_t)b), _flag(flag),
+  _start(Timeline::Enabled() ? Timeline::Now() : 0) { }
+  ~TimelineScope() {
+    if (!_start) return;
+    Timeline::Record(_kind, _start, Timeline::Now() - _start, _a, _flag ? *_flag : _b);
+  }
+};
+
+#ifdef USE_TIMELINE
+#define TIMELINE_SCOPE(...)\
+TimelineScope _timeline_scope(__VA_ARGS__)
+#define TIMELINE_EVENT(kind,a,b)\
+do { if (Timeline::Enabled()) Timeline::Record(kind, Timeline::Now(), 0, a, b); } while (0)
+#define TIMELINE_NOW()\
+(Timeline::Enabled() ? Timeline::Now() : 0)
+#define TIMELINE_SPAN(kind,start,a,b)\
+do { if (start) Timeline::Record(kind, start, Timeline::Now() - (start), a, b); } while (0)
+#else
+#define TIMELINE_SCOPE(...) ((void)0)
+#define TIMELINE_EVENT(kind,a,b) ((void)0)
+#define TIMELINE_NOW() ((uint64_t)0)
+#define TIMELINE_SPAN(kind,start,a,b) ((void)0)
+#endif
+
+#endif /* SUDOKUSOLVER_TIMELINE_HPP */
@@ -67,6 +67,15 @@ inline std_x::triple<UINT, UINT, UINT> GetCellGroups(UINT i) {
   return std_x::make_triple(i / (H * W), c, R * H + C);
 }
 
+// i-th term (counting from 1) of the Luby sequence 1,1,2,1,1,2,4,1,1,2,...
+// used to size search restarts
+inline UINT Luby(UINT i) {
+  UINT k = 1;
+  while ((UINT(1) << k) - 1 < i) ++k;
+  if (i == (UINT(1) << k) - 1) return UINT(1) << (k - 1);
+  return Luby(i - (UINT(1) << (k - 1)) + 1);
+}
+
 #define FORBITSIN(i,val) for (UINT i = __find_first(val); i < val.size(); i = __find_next(val,i))
 
 #endif /* SUDOKUSOLVER_UTILITY_HPP */
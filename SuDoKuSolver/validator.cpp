@@ -0,0 +1,167 @@
+//
+//  validator.cpp
+//  SuDoKuSolver
+//
+//  Copyright © 2018 Hermes Productions. All rights reserved.
+//
+
+#include "validator.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "dispatch.hpp"
+#include "parser.hpp"
+
+namespace {
+  // First cell where a solution doesn't keep its puzzle's clue, or n
+  UINT ChangedClue(const char* solution, const char* puzzle, UINT n) {
+    UINT i = 0;
+#ifdef __SSE2__
+    const __m128i blank = _mm_set1_epi8('.');
+    for (; i + 16 <= n; i += 16) {
+      __m128i s = _mm_loadu_si128((const __m128i*)(solution + i));
+      __m128i p = _mm_loadu_si128((const __m128i*)(puzzle + i));
+      __m128i kept = _mm_or_si128(_mm_cmpeq_epi8(s, p), _mm_cmpeq_epi8(p, blank));
+      int changed = _mm_movemask_epi8(kept) ^ 0xFFFF;
+      if (changed) return i + __builtin_ctz(changed);
+    }
+#endif
+    for (; i < n; ++i) {
+      if (puzzle[i] != '.' && puzzle[i] != solution[i]) return i;
+    }
+    return n;
+  }
+}
+
+const char* SolutionErrorName(SolutionError e) {
+  switch (e) {
+    case SolutionError::NONE: return "none";
+    case SolutionError::BAD_CHARACTER: return "bad_character";
+    case SolutionError::CLUE_CHANGED: return "clue_changed";
+    case SolutionError::CONFLICT: return "conflict";
+  }
+  return "unknown";
+}
+
+SolutionValidator::SolutionValidator(UINT size) {
+  const GridSize& g = GRID_SIZES[size];
+  _g = g.h * g.w;
+  _n = g.n;
+  _full = _g == 64 ? ~uint64_t(0) : (uint64_t(1) << _g) - 1;
+  // Cells in the order SudokuGrid numbers its groups, blocks being h rows
+  // by w columns
+  _groups.resize(3 * _n);
+  for (UINT i = 0; i < _n; ++i) {
+    UINT r = i / _g, c = i % _g;
+    UINT b = (r / g.h) * g.h + c / g.w;
+    UINT k = (r % g.h) * g.w + c % g.w;
+    _AT(_groups, r * _g + c) = i;
+    _AT(_groups, (_g + c) * _g + r) = i;
+    _AT(_groups, (2 * _g + b) * _g + k) = i;
+  }
+  if (_g <= 16) _narrow.resize(_n);
+  else _wide.resize(_n);
+  _values.resize(_n);
+}
+
+size_t SolutionValidator::Validate(const char* solutions, const char* puzzles, size_t n,
+                                   SolutionCheck* checks) {
+  size_t valid = 0;
+  for (size_t first = 0; first < n; first += LANES) {
+    UINT count = (UINT)std::min((size_t)LANES, n - first);
+    for (UINT lane = 0; lane < LANES; ++lane) {
+      // Lanes past the end, and solutions already found wrong, pass
+      if (lane >= count) {
+        Fill(lane);
+        continue;
+      }
+      size_t i = first + lane;
+      const char* solution = solutions + i * _n;
+      SolutionCheck& check = checks[i];
+      check = {SolutionError::NONE, 0};
+      ParseResult parsed = ParseValues(std::string_view(solution, _n), PuzzleDialect::Default(),
+                                       _n, _g, _values.data());
+      const void* blank = std::memchr(_values.data(), 0, _n);
+      if (parsed.error != ParseError::NONE) {
+        check = {SolutionError::BAD_CHARACTER, parsed.position};
+      } else if (blank) {
+        check = {SolutionError::BAD_CHARACTER, (UINT)((const uint8_t*)blank - _values.data())};
+      } else if (puzzles) {
+        UINT changed = ChangedClue(solution, puzzles + i * _n, _n);
+        if (changed < _n) check = {SolutionError::CLUE_CHANGED, changed};
+      }
+      if (check.error == SolutionError::NONE) Load(lane, _values.data());
+      else Fill(lane);
+    }
+    if (_g <= 16) CheckNarrow(checks + first, count);
+    else CheckWide(checks + first, count);
+    for (UINT lane = 0; lane < count; ++lane) {
+      valid += checks[first + lane].error == SolutionError::NONE;
+    }
+  }
+  return valid;
+}
+
+void SolutionValidator::Load(UINT lane, const uint8_t* values) {
+  if (_g <= 16) {
+    for (UINT i = 0; i < _n; ++i) _narrow[i].mask[lane] = (uint16_t)(1u << (values[i] - 1));
+  } else {
+    for (UINT i = 0; i < _n; ++i) _wide[i].mask[lane] = uint64_t(1) << (values[i] - 1);
+  }
+}
+
+void SolutionValidator::Fill(UINT lane) {
+  if (_g <= 16) {
+    for (UINT i = 0; i < _n; ++i) _narrow[i].mask[lane] = (uint16_t)_full;
+  } else {
+    for (UINT i = 0; i < _n; ++i) _wide[i].mask[lane] = _full;
+  }
+}
+
+void SolutionValidator::CheckNarrow(SolutionCheck* checks, UINT count) {
+  using namespace lanes;
+  const Lanes full = lanes::Fill((uint16_t)_full);
+  const UINT* cells = _groups.data();
+  for (UINT group = 0; group < 3 * _g; ++group, cells += _g) {
+    Lanes seen = Zero();
+    for (UINT i = 0; i < _g; ++i) seen = Or(seen, LoadLanes(_narrow[cells[i]].mask));
+    Lanes missing = Xor(seen, full);
+    if (Any(missing)) {
+      NarrowLanes out;
+      StoreLanes(out.mask, missing);
+      Conflicts(out.mask, group, checks, count);
+    }
+  }
+}
+
+// Plain loops over the lanes, which the compiler vectorises
+void SolutionValidator::CheckWide(SolutionCheck* checks, UINT count) {
+  const UINT* cells = _groups.data();
+  for (UINT group = 0; group < 3 * _g; ++group, cells += _g) {
+    WideLanes seen = {};
+    for (UINT i = 0; i < _g; ++i) {
+      const uint64_t* masks = _wide[cells[i]].mask;
+      for (UINT lane = 0; lane < LANES; ++lane) seen.mask[lane] |= masks[lane];
+    }
+    uint64_t any = 0;
+    for (UINT lane = 0; lane < LANES; ++lane) any |= seen.mask[lane] ^= _full;
+    if (any) Conflicts(seen.mask, group, checks, count);
+  }
+}
+
+// Marks the lanes missing a value in a group, keeping an earlier group's
+template <typename Mask>
+void SolutionValidator::Conflicts(const Mask* missing, UINT group, SolutionCheck* checks,
+                                  UINT count) {
+  for (UINT lane = 0; lane < count; ++lane) {
+    if (missing[lane] && checks[lane].error == SolutionError::NONE) {
+      checks[lane] = {SolutionError::CONFLICT, group};
+    }
+  }
+}
@@ -0,0 +1,69 @@
+//
+//  validator.hpp
+//  SuDoKuSolver
+//
+//  Copyright © 2018 Hermes Productions. All rights reserved.
+//
+
+#ifndef SUDOKUSOLVER_VALIDATOR_HPP
+#define SUDOKUSOLVER_VALIDATOR_HPP
+
+#include "defines.hpp"
+
+#include <cstdint>
+#include <vector>
+
+#include "lanes.hpp"
+
+// Why a submitted solution isn't one
+enum class SolutionError {
+  NONE,
+  BAD_CHARACTER,  // a blank, or not a value of the size
+  CLUE_CHANGED,   // differs from a clue of its puzzle
+  CONFLICT,       // a group missing a value, so another is repeated
+};
+
+const char* SolutionErrorName(SolutionError);
+
+struct SolutionCheck {
+  SolutionError error;
+  UINT position;  // the cell of a character or clue, or the group of a
+                  // conflict: rows, then columns, then blocks
+};
+
+// Checks completed grids of one size straight from their strings, without
+// building grids. Each cell becomes a one bit mask and the masks of sixteen
+// grids are ORed along every group together, one grid per lane, so a group
+// is complete when every lane equals the full mask. Keeps its buffers
+// between calls, so keep one per thread.
+class SolutionValidator {
+public:
+  explicit SolutionValidator(UINT size);  // index into GRID_SIZES
+
+  // n solutions packed back to back, in the default dialect, and the
+  // puzzles they were for, or null to check the groups only. Writes a
+  // check per solution and returns the number valid.
+  size_t Validate(const char* solutions, const char* puzzles, size_t n,
+                  SolutionCheck* checks);
+
+private:
+  static const UINT LANES = lanes::COUNT;
+  struct alignas(32) NarrowLanes { uint16_t mask[LANES]; };
+  struct WideLanes { uint64_t mask[LANES]; };
+
+  void Load(UINT lane, const uint8_t* values);
+  void Fill(UINT lane);
+  void CheckNarrow(SolutionCheck* checks, UINT count);
+  void CheckWide(SolutionCheck* checks, UINT count);
+  template <typename Mask>
+  void Conflicts(const Mask* missing, UINT group, SolutionCheck* checks, UINT count);
+
+  UINT _g, _n;
+  uint64_t _full;
+  std::vector<UINT> _groups;          // G cells for each of 3G groups
+  std::vector<NarrowLanes> _narrow;   // per cell, up to 16 values
+  std::vector<WideLanes> _wide;       // per cell, up to 64 values
+  std::vector<uint8_t> _values;
+};
+
+#endif /* SUDOKUSOLVER_VALIDATOR_HPP */
@@ -0,0 +1,107 @@
+//
+//  writer.cpp
+//  SuDoKuSolver
+//
+//  Copyright © 2018 Hermes Productions. All rights reserved.
+//
+
+#include "writer.hpp"
+
+#include <cstring>
+
+namespace {
+  // Two digits at a time, "00" to "99"
+  struct DigitPairs {
+    char pairs[200];
+    DigitPairs() {
+      for (UINT i = 0; i < 100; ++i) {
+        pairs[2 * i] = (char)('0' + i / 10);
+        pairs[2 * i + 1] = (char)('0' + i % 10);
+      }
+    }
+  };
+  const DigitPairs DIGITS;
+}
+
+ResultWriter::ResultWriter(std::ostream& out)
+: _out(out) {
+  _buffer.reserve(CAPACITY);
+  _thread = std::thread(&ResultWriter::Run, this);
+}
+
+ResultWriter::~ResultWriter() {
+  Close();
+}
+
+ResultWriter& ResultWriter::PutUint(uint64_t v) {
+  char digits[20];
+  char* p = digits + 20;
+  while (v >= 100) {
+    p -= 2;
+    std::memcpy(p, DIGITS.pairs + 2 * (v % 100), 2);
+    v /= 100;
+  }
+  if (v >= 10) {
+    p -= 2;
+    std::memcpy(p, DIGITS.pairs + 2 * v, 2);
+  } else {
+    *--p = (char)('0' + v);
+  }
+  _buffer.append(p, digits + 20 - p);
+  return *this;
+}
+
+void ResultWriter::Hand() {
+  if (_buffer.empty()) return;
+  _handed += _buffer.size();
+  std::string next;
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _done.wait(lock, [this] { return _full.size() < QUEUED; });
+    _full.push_back(std::move(_buffer));
+    if (!_free.empty()) {
+      next = std::move(_free.back());
+      _free.pop_back();
+    }
+  }
+  _wake.notify_one();
+  _buffer = std::move(next);
+  _buffer.reserve(CAPACITY);
+}
+
+void ResultWriter::Flush() {
+  Hand();
+  std::unique_lock<std::mutex> lock(_mutex);
+  _done.wait(lock, [this] { return _full.empty() && !_writing; });
+  lock.unlock();
+  _out.flush();
+}
+
+void ResultWriter::Close() {
+  if (!_thread.joinable()) return;
+  Flush();
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _closing = true;
+  }
+  _wake.notify_one();
+  _thread.join();
+}
+
+void ResultWriter::Run() {
+  std::unique_lock<std::mutex> lock(_mutex);
+  while (true) {
+    _wake.wait(lock, [this] { return _closing || !_full.empty(); });
+    if (_full.empty()) return;
+    std::string buffer = std::move(_full.front());
+    _full.pop_front();
+    _writing = true;
+    lock.unlock();
+    _out.write(buffer.data(), buffer.size());
+    buffer.clear();
+    lock.lock();
+    _writing = false;
+    _free.push_back(std::move(buffer));
+    _done.notify_all();
+  }
+}
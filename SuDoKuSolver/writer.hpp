@@ -0,0 +1,69 @@
+//
+//  writer.hpp
+//  SuDoKuSolver
+//
+//  Copyright © 2018 Hermes Productions. All rights reserved.
+//
+
+#ifndef SUDOKUSOLVER_WRITER_HPP
+#define SUDOKUSOLVER_WRITER_HPP
+
+#include "defines.hpp"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Formats result lines, or binary records, straight into large buffers and
+// hands full ones to a thread that writes them to the stream, so solving
+// never waits on output. Buffers are recycled once written, and more are
+// made only when the stream falls behind, up to QUEUED waiting at once;
+// past that, handing one on waits for the stream. Formatting is for one
+// thread at a time; use a writer per worker, each to its own stream.
+class ResultWriter {
+public:
+  static const UINT CAPACITY = 1 << 20;
+  static const UINT QUEUED = 4;
+
+  explicit ResultWriter(std::ostream&);
+  // Writes what is left, as Close
+  ~ResultWriter();
+
+  inline ResultWriter& Put(char c) { _buffer.push_back(c); return *this; }
+  inline ResultWriter& Put(std::string_view s) { _buffer.append(s.data(), s.size()); return *this; }
+  ResultWriter& PutUint(uint64_t);
+  // Ends a record, passing the buffer on once it is nearly full
+  inline ResultWriter& EndRecord() {
+    if (_buffer.size() >= CAPACITY - 4096) Hand();
+    return *this;
+  }
+  inline ResultWriter& EndLine() { return Put('\n').EndRecord(); }
+  // Bytes put since the start
+  inline uint64_t Written() const { return _handed + _buffer.size(); }
+  // Waits until everything put so far is in the stream
+  void Flush();
+  // As Flush, and stops the thread. Nothing can be put afterwards.
+  void Close();
+
+private:
+  void Hand();
+  void Run();
+
+  std::ostream& _out;
+  std::string _buffer;
+  uint64_t _handed = 0;
+  std::deque<std::string> _full;
+  std::vector<std::string> _free;
+  std::mutex _mutex;
+  std::condition_variable _wake, _done;
+  bool _writing = false, _closing = false;
+  std::thread _thread;
+};
+
+#endif /* SUDOKUSOLVER_WRITER_HPP */